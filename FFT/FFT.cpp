@@ -1,95 +1,1334 @@
 #include "FFT.hpp"
 
-FFT::FFT(int fft_length, float sample_rate) : fft_length(fft_length), sample_rate(sample_rate)
+#define FFT_WORKSPACE_ALIGN 8
+
+static size_t align_up(size_t bytes)
+{
+    return (bytes + FFT_WORKSPACE_ALIGN - 1) & ~(size_t)(FFT_WORKSPACE_ALIGN - 1);
+}
+
+FFT::FFT(int fft_length, float sample_rate, FFT_Mode mode)
+    : mode(mode), fft_length(fft_length), sample_rate(sample_rate),
+      workspace(NULL), workspace_size(0), workspace_used(0)
+{
+    init_buffers();
+}
+
+FFT::FFT(int fft_length, float sample_rate, void *workspace, size_t workspace_size, FFT_Mode mode)
+    : mode(mode), fft_length(fft_length), sample_rate(sample_rate),
+      workspace((uint8_t *)workspace), workspace_size(workspace_size), workspace_used(0)
+{
+    init_buffers();
+}
+
+FFT::~FFT()
+{
+    for (int i = 0; i < heap_count; i++)
+    {
+        free(heap_blocks[i]);
+    }
+}
+
+// The leading slack covers aligning an arbitrary arena base. Later blocks
+// pad by at most what align_up() already counts, so the per-feature sizes
+// below need no slack of their own.
+size_t FFT::Workspace_Size(int fft_length, FFT_Mode mode)
+{
+    size_t plan_size = align_up(FFT_Plan_Size(fft_length, mode == FFT_MODE_REAL));
+    size_t slack = FFT_WORKSPACE_ALIGN - 1;
+    if (mode == FFT_MODE_REAL)
+    {
+        return slack + align_up(fft_length * sizeof(float)) +
+               align_up(fft_length * sizeof(float)) + plan_size;
+    }
+    return slack + align_up(fft_length * 2 * sizeof(float)) +
+           align_up((fft_length / 2 + 1) * sizeof(float)) + plan_size;
+}
+
+bool FFT::Is_Supported(int fft_length, FFT_Mode mode)
+{
+    return FFT_Plan_Supported(fft_length, mode == FFT_MODE_REAL);
+}
+
+size_t FFT::Window_Workspace_Size(int fft_length)
+{
+    return align_up((fft_length / 2 + 1) * sizeof(float));
+}
+
+size_t FFT::Averaging_Workspace_Size(int fft_length)
+{
+    return align_up((fft_length / 2 + 1) * sizeof(float));
+}
+
+size_t FFT::Overlap_Workspace_Size(int fft_length)
+{
+    return align_up(fft_length * sizeof(uint16_t));
+}
+
+size_t FFT::Zoom_Workspace_Size(int fft_length)
+{
+    int taps = FFT_ZOOM_MAX_DECIMATION * FFT_ZOOM_TAPS_PER_PHASE;
+    return align_up(taps * sizeof(float)) + align_up(taps * 4 * sizeof(float)) +
+           align_up(fft_length * sizeof(float));
+}
+
+size_t FFT::Spectrogram_Workspace_Size(int fft_length, int rows)
+{
+    return align_up((size_t)rows * (fft_length / 2 + 1));
+}
+
+size_t FFT::Pitch_Workspace_Size(int fft_length, FFT_Mode mode)
 {
-    scfft = (arm_cfft_radix4_instance_f32 *)malloc(sizeof(arm_cfft_radix4_instance_f32));
-    if (scfft == NULL)
+    return mode == FFT_MODE_REAL ? align_up(fft_length * sizeof(float)) : 0;
+}
+
+void *FFT::allocate(size_t bytes)
+{
+    if (workspace == NULL)
     {
-        perror("Failed to allocate memory for FFT instance");
+        if (heap_count == FFT_MAX_HEAP_BLOCKS)
+        {
+            return NULL;
+        }
+        void *block = malloc(bytes);
+        if (block != NULL)
+        {
+            heap_blocks[heap_count++] = block;
+        }
+        return block;
+    }
+
+    uintptr_t base = (uintptr_t)(workspace + workspace_used);
+    size_t pad = align_up(base) - base;
+    if (workspace_used + pad + bytes > workspace_size)
+    {
+        return NULL;
+    }
+    void *block = workspace + workspace_used + pad;
+    workspace_used += pad + bytes;
+    return block;
+}
+
+void FFT::init_buffers()
+{
+    memset(main_Frequencies, 0, sizeof(main_Frequencies));
+    peak_count = 0;
+    heap_count = 0;
+    window = FFT_WINDOW_NONE;
+    window_table = NULL;
+    dc_removal = false;
+    average = FFT_AVERAGE_NONE;
+    average_alpha = 0.25f;
+    average_decimation = 1;
+    average_frames = 0;
+    avg_spectrum = NULL;
+    avg_spectrum_primed = false;
+    power_spectrum = false;
+    power_search = false;
+    units = FFT_UNITS_LINEAR;
+    tracking = false;
+    memset(&analysis, 0, sizeof(analysis));
+    memset(&cross, 0, sizeof(cross));
+    memset(&pitch, 0, sizeof(pitch));
+    pitch_min_lag = 2.0f;
+    pitch_max_lag = (float)(fft_length / 2 - 1);
+    pitch_buf = NULL;
+    overlap = FFT_OVERLAP_NONE;
+    history = NULL;
+    history_fill = 0;
+    zoom_enabled = false;
+    zoom_taps = NULL;
+    zoom_ring = NULL;
+    zoom_mag = NULL;
+    spectro_enabled = false;
+    spectro_data = NULL;
+    spectro_capacity = 0;
+    spectro_rows = 0;
+    spectro_head = 0;
+    spectro_count = 0;
+    spectro_floor = 0.0f;
+    spectro_range = 1.0f;
+
+    bool real = mode == FFT_MODE_REAL;
+    if (!FFT_Plan_Supported(fft_length, real))
+    {
+        errno = EINVAL;
+        perror("Unsupported FFT length");
         exit(EXIT_FAILURE);
     }
-    fft_inputbuf = (float *)malloc(fft_length * 2 * sizeof(float));
-    if (fft_inputbuf == NULL)
+
+    // The real transform consumes its input, so the magnitudes can reuse it
+    if (real)
+    {
+        fft_inputbuf = (float *)allocate(fft_length * sizeof(float));
+        fft_spectrum = (float *)allocate(fft_length * sizeof(float));
+        fft_outputbuf = fft_inputbuf;
+    }
+    else
     {
-        perror("Failed to allocate memory for FFT input buffer");
-        free(scfft);
+        fft_inputbuf = (float *)allocate(fft_length * 2 * sizeof(float));
+        fft_outputbuf = (float *)allocate((fft_length / 2 + 1) * sizeof(float));
+        fft_spectrum = fft_inputbuf;
+    }
+    size_t plan_size = FFT_Plan_Size(fft_length, real);
+    void *tables = plan_size > 0 ? allocate(plan_size) : NULL;
+    if (fft_inputbuf == NULL || fft_spectrum == NULL || fft_outputbuf == NULL ||
+        (plan_size > 0 && tables == NULL))
+    {
+        errno = ENOMEM;
+        perror("Failed to allocate memory for FFT buffers");
         exit(EXIT_FAILURE);
     }
-    arm_cfft_radix4_init_f32(scfft, fft_length, 0, 1);
+    FFT_Plan_Init(&plan, fft_length, real, tables);
 }
 
-FFT::~FFT()
+
+void FFT::find_main_freq(const float *spectrum, int first, int last, float bin_hz, float base_hz, bool power)
 {
-    free(fft_inputbuf);
-    free(scfft);
+    if (tracking)
+    {
+        peak_count = tracker.Update(spectrum, first, last, bin_hz, base_hz, peak_finder);
+        const FFT_Track *t = tracker.getTracks();
+        for (int i = 0; i < peak_count; i++)
+        {
+            tracks[i] = t[i];
+            peaks[i].frequency = t[i].frequency;
+            peaks[i].magnitude = t[i].magnitude;
+            peaks[i].bin = t[i].bin;
+        }
+    }
+    else
+    {
+        peak_count = peak_finder.Find(spectrum, first, last, bin_hz, base_hz, peaks);
+    }
+
+    for (int i = 0; i < FFT_MAX_PEAKS; i++)
+    {
+        main_Frequencies[i] = i < peak_count ? peaks[i].frequency : 0.0f;
+        if (i < peak_count)
+        {
+            peaks[i].magnitude = report_magnitude(peaks[i].magnitude, power);
+            if (tracking)  tracks[i].magnitude = peaks[i].magnitude;
+        }
+    }
 }
 
+// Converts a peak height from the search domain to the reported units. The
+// sqrt or log is only paid for the handful of peaks, never per bin.
+float FFT::report_magnitude(float height, bool power)
+{
+    if (units == FFT_UNITS_DB)
+    {
+        height = height > 1e-30f ? height : 1e-30f;
+        return (power ? 10.0f : 20.0f) * log10f(height);
+    }
+    return power ? sqrtf(height) : height;
+}
 
-void FFT::find_main_freq(float *fft_outputbuf)
+// Widens, de-means and windows the samples in one pass. STEP is 2 when the
+// destination is an interleaved complex buffer; stride steps over the
+// other channels of an interleaved ADC scan.
+template <int STEP, typename T>
+static void convert_samples(float *out, const T *adc, int stride, int length, float offset, const float *window)
 {
-    float max_mag = 0;
-    uint16_t max_idx = 0;
-    for (int i = 1; i < fft_length / 2; i++)
-    { 
-        if (fft_outputbuf[i] > max_mag)
+    if (window == NULL)
+    {
+        for (int i = 0; i < length; i++)
         {
-            max_mag = fft_outputbuf[i];
-            max_idx = i;
+            out[STEP * i] = (float)adc[i * stride] - offset;
+            if (STEP == 2)  out[STEP * i + 1] = 0.0f;
         }
+        return;
+    }
+
+    int half = length / 2;
+    for (int i = 0; i <= half; i++)
+    {
+        out[STEP * i] = ((float)adc[i * stride] - offset) * window[i];
+        if (STEP == 2)  out[STEP * i + 1] = 0.0f;
+    }
+    for (int i = half + 1; i < length; i++)
+    {
+        out[STEP * i] = ((float)adc[i * stride] - offset) * window[length - i];
+        if (STEP == 2)  out[STEP * i + 1] = 0.0f;
+    }
+}
+
+// Integer samples sum exactly in 32 bits; floats accumulate as floats
+static float sample_mean(const uint16_t *adc, int stride, int length)
+{
+    uint32_t sum = 0;
+    for (int i = 0; i < length; i++)
+    {
+        sum += adc[i * stride];
+    }
+    return (float)sum / length;
+}
+
+static float sample_mean(const float *samples, int stride, int length)
+{
+    float sum = 0.0f;
+    for (int i = 0; i < length; i++)
+    {
+        sum += samples[i * stride];
     }
+    return sum / length;
+}
+
+template <typename T>
+void FFT::convert_frame(const T *samples, int stride)
+{
+    float offset = dc_removal ? sample_mean(samples, stride, fft_length) : 0.0f;
+    const float *coefficients = window != FFT_WINDOW_NONE ? window_table : NULL;
+    if (mode == FFT_MODE_REAL)
+    {
+        convert_samples<1>(fft_inputbuf, samples, stride, fft_length, offset, coefficients);
+    }
+    else
+    {
+        convert_samples<2>(fft_inputbuf, samples, stride, fft_length, offset, coefficients);
+    }
+}
 
-    float top5_mag[5] = {0};
-    uint16_t top5_idx[5] = {0};
+void FFT::convert(uint16_t *adc_buffer)
+{
+    convert_frame(adc_buffer, 1);
+}
+
+void FFT::convert(const uint16_t *adc_buffer, int stride)
+{
+    convert_frame(adc_buffer, stride);
+}
 
-    for (int i = 1; i < fft_length / 2; i++)
-    { 
-        float current_mag = fft_outputbuf[i];
+void FFT::convert(const float *samples, int stride)
+{
+    convert_frame(samples, stride);
+}
 
-        for (int j = 0; j < 5; j++)
+void FFT::transform()
+{
+    if (mode == FFT_MODE_REAL)
+    {
+        FFT_Forward_Real(&plan, fft_inputbuf, fft_spectrum);
+    }
+    else
+    {
+        FFT_Forward_Complex(&plan, fft_inputbuf);
+    }
+}
+
+void FFT::magnitude()
+{
+    if (power_spectrum)
+    {
+        if (mode == FFT_MODE_REAL)
         {
-            if (current_mag > top5_mag[j])
+            fft_outputbuf[0] = fft_spectrum[0] * fft_spectrum[0];
+            fft_outputbuf[fft_length / 2] = fft_spectrum[1] * fft_spectrum[1];
+            FFT_Magnitude_Squared(fft_spectrum + 2, fft_outputbuf + 1, fft_length / 2 - 1);
+        }
+        else
+        {
+            FFT_Magnitude_Squared(fft_spectrum, fft_outputbuf, fft_length / 2 + 1);
+        }
+        return;
+    }
+
+    if (mode == FFT_MODE_REAL)
+    {
+        // Bins 0 and N/2 are purely real and packed into the first pair
+        fft_outputbuf[0] = fabsf(fft_spectrum[0]);
+        fft_outputbuf[fft_length / 2] = fabsf(fft_spectrum[1]);
+        FFT_Magnitude(fft_spectrum + 2, fft_outputbuf + 1, fft_length / 2 - 1);
+    }
+    else
+    {
+        FFT_Magnitude(fft_spectrum, fft_outputbuf, fft_length / 2 + 1);
+    }
+}
+
+// Folds this frame's |X|^2 into avg_spectrum; true when a report is due
+bool FFT::accumulate()
+{
+    int bins = fft_length / 2 + 1;
+    average_frames++;
+
+    // Running mean for linear averaging, restarted at the first frame of
+    // each block; the first frame seeds the other modes
+    float weight = average == FFT_AVERAGE_LINEAR ? 1.0f / average_frames :
+                   avg_spectrum_primed ? average_alpha : 1.0f;
+    switch (average)
+    {
+    case FFT_AVERAGE_PEAK_HOLD:
+        FFT_Peak_Hold(avg_spectrum, fft_outputbuf, weight, bins);
+        break;
+    case FFT_AVERAGE_MIN_HOLD:
+        FFT_Min_Hold(avg_spectrum, fft_outputbuf, weight, bins);
+        break;
+    default:
+        FFT_Smooth(avg_spectrum, fft_outputbuf, weight, bins);
+        break;
+    }
+    avg_spectrum_primed = true;
+    if (average_frames < average_decimation)
+    {
+        return false;
+    }
+    average_frames = 0;
+    return true;
+}
+
+bool FFT::FFT_PROCESS(uint16_t *adc_buffer)
+{
+    convert(adc_buffer);
+    transform();
+    magnitude();
+    record();
+    return search();
+}
+
+bool FFT::FFT_PROCESS(const float *samples)
+{
+    convert(samples, 1);
+    transform();
+    magnitude();
+    record();
+    return search();
+}
+
+// log2 from the float's exponent plus a quadratic in the mantissa, within
+// 0.005 (0.03 dB), which is far below one 8-bit step
+static inline float fast_log2(float x)
+{
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    float exponent = (float)((int)(bits >> 23) - 127);
+    bits = (bits & 0x007FFFFF) | 0x3F800000;
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+    return exponent + (-0.34484843f * m + 2.02466578f) * m - 1.67487759f;
+}
+
+// Quantises this frame's magnitudes into the next spectrogram row
+void FFT::record()
+{
+    if (!spectro_enabled)
+    {
+        return;
+    }
+
+    int bins = fft_length / 2 + 1;
+    uint8_t *row = spectro_data + (size_t)spectro_head * bins;
+    // dB = k * log2(x), k = 20*log10(2) for |X| and half that for |X|^2
+    float scale = 255.0f / spectro_range;
+    float gain = (power_spectrum ? 3.01029996f : 6.02059991f) * scale;
+    float offset = -spectro_floor * scale + 0.5f;
+    for (int i = 0; i < bins; i++)
+    {
+        float q = gain * fast_log2(fft_outputbuf[i]) + offset;
+        q = q < 0.0f ? 0.0f : q;
+        q = q > 255.0f ? 255.0f : q;
+        row[i] = (uint8_t)q;
+    }
+
+    spectro_head = spectro_head + 1 == spectro_rows ? 0 : spectro_head + 1;
+    if (spectro_count < spectro_rows)
+    {
+        spectro_count++;
+    }
+}
+
+// Averaging and peak search; true when the peak list was updated
+bool FFT::search()
+{
+    if (average == FFT_AVERAGE_NONE)
+    {
+        find_main_freq(fft_outputbuf, 1, fft_length / 2 - 1, sample_rate / fft_length, 0.0f, power_spectrum);
+        return true;
+    }
+    if (!accumulate())
+    {
+        return false;
+    }
+    find_main_freq(avg_spectrum, 1, fft_length / 2 - 1, sample_rate / fft_length, 0.0f, power_spectrum);
+    return true;
+}
+
+bool FFT::FFT_PUSH(uint16_t *samples)
+{
+    if (overlap == FFT_OVERLAP_NONE)
+    {
+        return FFT_PROCESS(samples);
+    }
+
+    // Slide the frame by one hop and append the new samples
+    int hop = getHopLength();
+    int keep = fft_length - hop;
+    memmove(history, history + hop, keep * sizeof(uint16_t));
+    memcpy(history + keep, samples, hop * sizeof(uint16_t));
+
+    // The first frame is only complete once fft_length samples have arrived
+    if (history_fill < fft_length)
+    {
+        history_fill += hop;
+        if (history_fill < fft_length)
+        {
+            return false;
+        }
+    }
+    return FFT_PROCESS(history);
+}
+
+static float to_db(float ratio)
+{
+    return 10.0f * log10f(ratio > 1e-30f ? ratio : 1e-30f);
+}
+
+bool FFT::Analyze(int harmonics)
+{
+    const float *spectrum = average != FFT_AVERAGE_NONE ? avg_spectrum : fft_outputbuf;
+    int last = fft_length / 2;
+    int lobe = FFT_WINDOW_LOBE_BINS[window];
+    float bin_hz = sample_rate / fft_length;
+    if (harmonics > FFT_MAX_HARMONICS)
+    {
+        harmonics = FFT_MAX_HARMONICS;
+    }
+
+    // Bins claimed by DC, the fundamental and the harmonics; the rest is noise
+    int lo[FFT_MAX_HARMONICS + 1];
+    int hi[FFT_MAX_HARMONICS + 1];
+    int ranges = 0;
+    lo[ranges] = 0;
+    hi[ranges++] = lobe;
+
+    int fund = -1;
+    float fund_power = 0.0f;
+    for (int i = lobe + 1; i < last; i++)
+    {
+        float p = power_spectrum ? spectrum[i] : spectrum[i] * spectrum[i];
+        if (p > fund_power)
+        {
+            fund_power = p;
+            fund = i;
+        }
+    }
+    if (fund < 0)
+    {
+        return false;
+    }
+
+    float height;
+    float offset = peak_finder.Interpolate(spectrum + fund - 1, &height);
+    analysis.fundamental = (fund + offset) * bin_hz;
+    analysis.amplitude = report_magnitude(height, power_spectrum);
+
+    float signal = 0.0f;
+    lo[ranges] = fund - lobe;
+    hi[ranges++] = fund + lobe < last ? fund + lobe : last;
+    for (int i = fund - lobe; i <= hi[1]; i++)
+    {
+        signal += power_spectrum ? spectrum[i] : spectrum[i] * spectrum[i];
+    }
+
+    float distortion = 0.0f;
+    analysis.harmonic_count = 0;
+    for (int order = 2; order <= harmonics; order++)
+    {
+        // Harmonics above Nyquist fold back into the band
+        float f = fmodf(order * analysis.fundamental, sample_rate);
+        if (f > 0.5f * sample_rate)
+        {
+            f = sample_rate - f;
+        }
+        int centre = (int)(f / bin_hz + 0.5f);
+
+        // Skip harmonics that land on the DC or fundamental lobe
+        if (centre <= 2 * lobe || abs(centre - fund) <= 2 * lobe)
+        {
+            continue;
+        }
+        int first = centre - lobe;
+        int end = centre + lobe < last ? centre + lobe : last;
+        float power = 0.0f;
+        for (int i = first; i <= end; i++)
+        {
+            power += power_spectrum ? spectrum[i] : spectrum[i] * spectrum[i];
+        }
+        distortion += power;
+        lo[ranges] = first;
+        hi[ranges++] = end;
+
+        FFT_Harmonic *h = &analysis.harmonics[analysis.harmonic_count++];
+        h->order = order;
+        h->frequency = f;
+        h->level = to_db(power / signal);
+    }
+
+    // Noise from the unclaimed bins, scaled up to cover the claimed ones
+    float noise = 0.0f;
+    float spur = 0.0f;
+    int noise_bins = 0;
+    for (int i = lobe + 1; i <= last; i++)
+    {
+        float p = power_spectrum ? spectrum[i] : spectrum[i] * spectrum[i];
+        if (i < lo[1] || i > hi[1])
+        {
+            spur = p > spur ? p : spur;
+        }
+        bool claimed = false;
+        for (int r = 1; r < ranges; r++)
+        {
+            if (i >= lo[r] && i <= hi[r])
             {
-                for (int k = 4; k > j; k--)
-                {
-                    top5_mag[k] = top5_mag[k - 1];
-                    top5_idx[k] = top5_idx[k - 1];
-                }
-                top5_mag[j] = current_mag;
-                top5_idx[j] = i;
+                claimed = true;
                 break;
             }
         }
+        if (!claimed)
+        {
+            noise += p;
+            noise_bins++;
+        }
     }
+    if (noise_bins > 0)
+    {
+        noise *= (float)(last - lobe) / noise_bins;
+    }
+
+    analysis.noise_floor = to_db(noise / (last - lobe) / signal);
+    analysis.thd = to_db(distortion / signal);
+    analysis.snr = to_db(signal / noise);
+    analysis.sinad = to_db(signal / (noise + distortion));
+    analysis.sfdr = to_db(fund_power / spur);
+    analysis.enob = (analysis.sinad - 1.76f) / 6.02f;
+    return true;
+}
+
+const FFT_Analysis *FFT::getAnalysis()
+{
+    return &analysis;
+}
 
-    for (int i = 0; i < 5; i++)
+bool FFT::setPitchRange(float min_hz, float max_hz)
+{
+    if (min_hz <= 0.0f || max_hz <= min_hz)
+    {
+        return false;
+    }
+    if (mode == FFT_MODE_REAL && pitch_buf == NULL)
     {
-        main_Frequencies[i] = (top5_idx[i] * sample_rate) / fft_length;
+        pitch_buf = (float *)allocate(fft_length * sizeof(float));
+        if (pitch_buf == NULL)
+        {
+            return false;
+        }
     }
+    pitch_min_lag = sample_rate / max_hz;
+    pitch_max_lag = sample_rate / min_hz;
+    return true;
 }
 
-void FFT::FFT_PROCESS(uint16_t *adc_buffer)
+bool FFT::EstimatePitch()
 {
-    float *fft_outputbuf = (float *)malloc(fft_length * sizeof(float));
+    if (mode == FFT_MODE_REAL && pitch_buf == NULL)
+    {
+        return false;
+    }
 
-    if (fft_outputbuf == NULL)
+    // Wiener-Khinchin: r = IFFT(|X|^2). DC is dropped so the mean does not
+    // swamp the lags.
+    const float *spectrum = average != FFT_AVERAGE_NONE ? avg_spectrum : fft_outputbuf;
+    int half = fft_length / 2;
+    const float *r;
+    if (mode == FFT_MODE_REAL)
     {
-        perror("Failed to allocate memory for FFT output buffer");
-        free(fft_inputbuf);
-        free(scfft);
-        exit(EXIT_FAILURE);
+        float *packed = fft_spectrum;
+        packed[0] = 0.0f;
+        packed[1] = power_spectrum ? spectrum[half] : spectrum[half] * spectrum[half];
+        for (int k = 1; k < half; k++)
+        {
+            packed[2 * k] = power_spectrum ? spectrum[k] : spectrum[k] * spectrum[k];
+            packed[2 * k + 1] = 0.0f;
+        }
+        FFT_Inverse_Real(&plan, packed, pitch_buf);
+        r = pitch_buf;
+    }
+    else
+    {
+        float *full = fft_inputbuf;
+        memset(full, 0, fft_length * 2 * sizeof(float));
+        for (int k = 1; k <= half; k++)
+        {
+            float p = power_spectrum ? spectrum[k] : spectrum[k] * spectrum[k];
+            full[2 * k] = p;
+            full[2 * (fft_length - k)] = p;
+        }
+        FFT_Inverse_Complex(&plan, full);
+        // Real parts only, compacted so r reads like the real-mode output
+        for (int i = 1; i <= half; i++)
+        {
+            full[i] = full[2 * i];
+        }
+        r = full;
+    }
+
+    pitch.frequency = 0.0f;
+    pitch.lag = 0.0f;
+    pitch.confidence = 0.0f;
+    int first = (int)ceilf(pitch_min_lag);
+    int last = (int)pitch_max_lag;
+    first = first < 1 ? 1 : first;
+    last = last > half - 1 ? half - 1 : last;
+    if (first > last || r[0] <= 0.0f)
+    {
+        return false;
+    }
+
+    // Taking the first near-maximal peak rather than the maximum avoids
+    // octave errors at multiples of the period
+    float strongest = 0.0f;
+    for (int i = first; i <= last; i++)
+    {
+        strongest = r[i] > strongest ? r[i] : strongest;
+    }
+    if (strongest <= 0.0f)
+    {
+        return false;
+    }
+    int lag = -1;
+    for (int i = first; i <= last; i++)
+    {
+        if (r[i] >= 0.9f * strongest && r[i] >= r[i - 1] && r[i] >= r[i + 1])
+        {
+            lag = i;
+            break;
+        }
+    }
+    if (lag < 0)
+    {
+        return false;
+    }
+
+    float denom = r[lag - 1] - 2.0f * r[lag] + r[lag + 1];
+    float offset = denom < 0.0f ? 0.5f * (r[lag - 1] - r[lag + 1]) / denom : 0.0f;
+
+    // The window's own circular autocorrelation tapers r; divide it out
+    float taper = 1.0f;
+    if (window != FFT_WINDOW_NONE)
+    {
+        float w0 = 0.0f;
+        float wl = 0.0f;
+        for (int i = 0; i < fft_length; i++)
+        {
+            int j = i + lag < fft_length ? i + lag : i + lag - fft_length;
+            float a = window_table[i <= half ? i : fft_length - i];
+            float b = window_table[j <= half ? j : fft_length - j];
+            w0 += a * a;
+            wl += a * b;
+        }
+        taper = wl / w0;
+    }
+
+    pitch.lag = lag + offset;
+    pitch.frequency = sample_rate / pitch.lag;
+    float confidence = r[lag] / (r[0] * taper);
+    pitch.confidence = confidence > 1.0f ? 1.0f : confidence;
+    return true;
+}
+
+const FFT_Pitch *FFT::getPitch()
+{
+    return &pitch;
+}
+
+// Channel A into the real parts and B into the imaginary parts, each
+// de-meaned on its own and windowed alike so the window cancels in the phase
+void FFT::convert_pair(const uint16_t *adc_a, const uint16_t *adc_b, int stride)
+{
+    float offset_a = 0.0f;
+    float offset_b = 0.0f;
+    if (dc_removal)
+    {
+        uint32_t sum_a = 0;
+        uint32_t sum_b = 0;
+        for (int i = 0; i < fft_length; i++)
+        {
+            sum_a += adc_a[i * stride];
+            sum_b += adc_b[i * stride];
+        }
+        offset_a = (float)sum_a / fft_length;
+        offset_b = (float)sum_b / fft_length;
     }
 
     for (int i = 0; i < fft_length; i++)
     {
-        fft_inputbuf[2 * i] = (float)adc_buffer[i];
-        fft_inputbuf[2 * i + 1] = 0;
+        float w = window != FFT_WINDOW_NONE ? window_table[i <= fft_length / 2 ? i : fft_length - i] : 1.0f;
+        fft_inputbuf[2 * i] = ((float)adc_a[i * stride] - offset_a) * w;
+        fft_inputbuf[2 * i + 1] = ((float)adc_b[i * stride] - offset_b) * w;
+    }
+}
+
+bool FFT::FFT_CROSS_PROCESS(const uint16_t *adc_a, const uint16_t *adc_b, int stride)
+{
+    if (mode != FFT_MODE_COMPLEX)
+    {
+        return false;
+    }
+    convert_pair(adc_a, adc_b, stride);
+    FFT_Forward_Complex(&plan, fft_inputbuf);
+
+    // X[k] = (Z[k] + Z*[N-k]) / 2 and Y[k] = (Z[k] - Z*[N-k]) / 2j. Bin k is
+    // only read again by bin N-k > N/2, so X * conj(Y) can overwrite it.
+    int bins = fft_length / 2 + 1;
+    float *z = fft_inputbuf;
+    for (int k = 0; k < bins; k++)
+    {
+        int m = k == 0 ? 0 : fft_length - k;
+        float xr = 0.5f * (z[2 * k] + z[2 * m]);
+        float xi = 0.5f * (z[2 * k + 1] - z[2 * m + 1]);
+        float yr = 0.5f * (z[2 * k + 1] + z[2 * m + 1]);
+        float yi = -0.5f * (z[2 * k] - z[2 * m]);
+        z[2 * k] = xr * yr + xi * yi;
+        z[2 * k + 1] = xi * yr - xr * yi;
+    }
+
+    // |X * conj(Y)| = |X| * |Y| is already a power, like |X|^2
+    FFT_Magnitude(z, fft_outputbuf, bins);
+    float bin_hz = sample_rate / fft_length;
+    find_main_freq(fft_outputbuf, 1, fft_length / 2 - 1, bin_hz, 0.0f, true);
+    cross_phase(bin_hz);
+    return true;
+}
+
+// Phase of each peak's cross bin, and the weighted least-squares slope of
+// the unwrapped phase over frequency for the group delay
+void FFT::cross_phase(float bin_hz)
+{
+    const float two_pi = 6.28318530717958647692f;
+    cross.peak_count = peak_count;
+    for (int i = 0; i < peak_count; i++)
+    {
+        FFT_CrossPeak *p = &cross.peaks[i];
+        const float *s = fft_inputbuf + 2 * peaks[i].bin;
+        p->frequency = peaks[i].frequency;
+        p->magnitude = peaks[i].magnitude;
+        p->phase = atan2f(s[1], s[0]);
+        p->delay = p->frequency > 0.0f ? -p->phase / (two_pi * p->frequency) : 0.0f;
+    }
+
+    cross.group_delay = 0.0f;
+    if (peak_count < 2)
+    {
+        return;
+    }
+
+    int order[FFT_MAX_PEAKS];
+    for (int i = 0; i < peak_count; i++)
+    {
+        int j = i;
+        while (j > 0 && cross.peaks[order[j - 1]].frequency > cross.peaks[i].frequency)
+        {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    // Weighted by |X||Y| so leakage and noise peaks barely pull the fit
+    float total = 0.0f;
+    float mean_f = 0.0f;
+    float mean_phi = 0.0f;
+    float phi[FFT_MAX_PEAKS];
+    float weight[FFT_MAX_PEAKS];
+    for (int i = 0; i < peak_count; i++)
+    {
+        phi[i] = cross.peaks[order[i]].phase;
+        if (i > 0)
+        {
+            phi[i] -= two_pi * roundf((phi[i] - phi[i - 1]) / two_pi);
+        }
+        weight[i] = fft_outputbuf[peaks[order[i]].bin];
+        total += weight[i];
+        mean_f += weight[i] * cross.peaks[order[i]].frequency;
+        mean_phi += weight[i] * phi[i];
+    }
+    if (total <= 0.0f)
+    {
+        return;
+    }
+    mean_f /= total;
+    mean_phi /= total;
+
+    float sff = 0.0f;
+    float sfp = 0.0f;
+    for (int i = 0; i < peak_count; i++)
+    {
+        float df = cross.peaks[order[i]].frequency - mean_f;
+        sff += weight[i] * df * df;
+        sfp += weight[i] * df * (phi[i] - mean_phi);
+    }
+    // Peaks within about a bin of each other carry no slope information
+    if (sff > bin_hz * bin_hz * total)
+    {
+        cross.group_delay = -sfp / sff / two_pi;
+    }
+}
+
+const FFT_Cross *FFT::getCross()
+{
+    return &cross;
+}
+
+const float *FFT::getCrossSpectrum()
+{
+    return mode == FFT_MODE_COMPLEX ? fft_inputbuf : NULL;
+}
+
+bool FFT::setZoom(float centre, int decimation)
+{
+    if (mode != FFT_MODE_COMPLEX || decimation < 2 || decimation > FFT_ZOOM_MAX_DECIMATION)
+    {
+        return false;
+    }
+
+    // Sized for the largest decimation so later changes never reallocate
+    if (zoom_taps == NULL)
+    {
+        int max_taps = FFT_ZOOM_MAX_DECIMATION * FFT_ZOOM_TAPS_PER_PHASE;
+        zoom_taps = (float *)allocate(max_taps * sizeof(float));
+        zoom_ring = (float *)allocate(max_taps * 4 * sizeof(float));
+        zoom_mag = (float *)allocate(fft_length * sizeof(float));
+        if (zoom_taps == NULL || zoom_ring == NULL || zoom_mag == NULL)
+        {
+            zoom_taps = NULL;
+            return false;
+        }
+    }
+
+    // Blackman-windowed sinc with its cutoff at the decimated Nyquist
+    int taps = decimation * FFT_ZOOM_TAPS_PER_PHASE;
+    float cutoff = 0.5f / decimation;
+    float sum = 0.0f;
+    for (int i = 0; i < taps; i++)
+    {
+        float t = i - 0.5f * (taps - 1);
+        float x = 3.14159265f * 2.0f * cutoff * t;
+        float sinc = fabsf(x) < 1e-6f ? 1.0f : sinf(x) / x;
+        float w = 0.42f - 0.5f * cosf(6.2831853f * (i + 0.5f) / taps) +
+                  0.08f * cosf(12.5663706f * (i + 0.5f) / taps);
+        zoom_taps[i] = sinc * w;
+        sum += zoom_taps[i];
+    }
+    for (int i = 0; i < taps; i++)
+    {
+        zoom_taps[i] /= sum;
+    }
+
+    memset(zoom_ring, 0, taps * 4 * sizeof(float));
+    zoom_tap_count = taps;
+    zoom_ring_pos = 0;
+    zoom_centre = centre;
+    zoom_decimation = decimation;
+    zoom_phase[0] = 1.0f;
+    zoom_phase[1] = 0.0f;
+    zoom_step[0] = cosf(6.2831853f * centre / sample_rate);
+    zoom_step[1] = -sinf(6.2831853f * centre / sample_rate);
+    zoom_count = 0;
+    zoom_fill = 0;
+    zoom_offset = 0.0f;
+    zoom_sum = 0;
+    zoom_sum_count = 0;
+    zoom_enabled = true;
+    tracker.Reset();
+    return true;
+}
+
+void FFT::disableZoom()
+{
+    zoom_enabled = false;
+    tracker.Reset();
+}
+
+const float *FFT::getZoomSpectrum()
+{
+    return zoom_enabled ? zoom_mag : NULL;
+}
+
+bool FFT::FFT_ZOOM_PUSH(uint16_t *samples, int count)
+{
+    if (!zoom_enabled)
+    {
+        return false;
+    }
+
+    bool updated = false;
+    int taps = zoom_tap_count;
+    for (int n = 0; n < count; n++)
+    {
+        zoom_sum += samples[n];
+        if (++zoom_sum_count == fft_length)
+        {
+            zoom_offset = (float)zoom_sum / fft_length;
+            zoom_sum = 0;
+            zoom_sum_count = 0;
+        }
+
+        // Mix down and append to the duplicated delay line
+        float x = (float)samples[n] - zoom_offset;
+        float *slot = zoom_ring + 2 * zoom_ring_pos;
+        slot[0] = slot[2 * taps] = x * zoom_phase[0];
+        slot[1] = slot[2 * taps + 1] = x * zoom_phase[1];
+        if (++zoom_ring_pos == taps)
+        {
+            zoom_ring_pos = 0;
+        }
+
+        float re = zoom_phase[0] * zoom_step[0] - zoom_phase[1] * zoom_step[1];
+        float im = zoom_phase[0] * zoom_step[1] + zoom_phase[1] * zoom_step[0];
+        zoom_phase[0] = re;
+        zoom_phase[1] = im;
+
+        if (++zoom_count < zoom_decimation)
+        {
+            continue;
+        }
+        zoom_count = 0;
+
+        // Keep the phasor on the unit circle
+        float gain = 1.5f - 0.5f * (re * re + im * im);
+        zoom_phase[0] *= gain;
+        zoom_phase[1] *= gain;
+
+        // FIR output only at the decimated rate
+        const float *line = zoom_ring + 2 * zoom_ring_pos;
+        float acc_re = 0.0f;
+        float acc_im = 0.0f;
+        for (int i = 0; i < taps; i++)
+        {
+            acc_re += zoom_taps[i] * line[2 * i];
+            acc_im += zoom_taps[i] * line[2 * i + 1];
+        }
+        fft_inputbuf[2 * zoom_fill] = acc_re;
+        fft_inputbuf[2 * zoom_fill + 1] = acc_im;
+        if (++zoom_fill == fft_length)
+        {
+            zoom_fill = 0;
+            zoom_frame();
+            updated = true;
+        }
+    }
+    return updated;
+}
+
+// Windows, transforms and searches one frame of decimated baseband
+void FFT::zoom_frame()
+{
+    if (window != FFT_WINDOW_NONE)
+    {
+        for (int i = 0; i < fft_length; i++)
+        {
+            float w = window_table[i <= fft_length / 2 ? i : fft_length - i];
+            fft_inputbuf[2 * i] *= w;
+            fft_inputbuf[2 * i + 1] *= w;
+        }
+    }
+
+    FFT_Forward_Complex(&plan, fft_inputbuf);
+
+    // Negative frequencies first so the spectrum reads low to high; odd
+    // lengths have one more non-negative bin than negative ones
+    int half = fft_length / 2;
+    int positive = fft_length - half;
+    if (power_search)
+    {
+        FFT_Magnitude_Squared(fft_inputbuf + 2 * positive, zoom_mag, half);
+        FFT_Magnitude_Squared(fft_inputbuf, zoom_mag + half, positive);
+    }
+    else
+    {
+        FFT_Magnitude(fft_inputbuf + 2 * positive, zoom_mag, half);
+        FFT_Magnitude(fft_inputbuf, zoom_mag + half, positive);
+    }
+
+    float bin_hz = sample_rate / ((float)zoom_decimation * fft_length);
+    find_main_freq(zoom_mag, 1, fft_length - 2, bin_hz, zoom_centre - half * bin_hz, power_search);
+}
+
+int FFT::getHopLength()
+{
+    switch (overlap)
+    {
+    case FFT_OVERLAP_50:
+        return fft_length / 2;
+    case FFT_OVERLAP_75:
+        return fft_length / 4;
+    default:
+        return fft_length;
+    }
+}
+
+bool FFT::setWindow(FFT_Window window)
+{
+    if (window == FFT_WINDOW_NONE)
+    {
+        this->window = window;
+        return true;
+    }
+
+    // The table survives window changes so an arena is only charged once
+    if (window_table == NULL)
+    {
+        window_table = (float *)allocate((fft_length / 2 + 1) * sizeof(float));
+        if (window_table == NULL)
+        {
+            return false;
+        }
+    }
+
+    for (int i = 0; i <= fft_length / 2; i++)
+    {
+        window_table[i] = FFT_Window_Coefficient(window, i, fft_length);
+    }
+    this->window = window;
+    return true;
+}
+
+FFT_Window FFT::getWindow()
+{
+    return window;
+}
+
+void FFT::setDCRemoval(bool enable)
+{
+    dc_removal = enable;
+}
+
+bool FFT::setAveraging(FFT_Average average, int decimation, float alpha)
+{
+    if (average != FFT_AVERAGE_NONE && avg_spectrum == NULL)
+    {
+        avg_spectrum = (float *)allocate((fft_length / 2 + 1) * sizeof(float));
+        if (avg_spectrum == NULL)
+        {
+            return false;
+        }
+    }
+
+    this->average = average;
+    average_decimation = decimation < 1 ? 1 : decimation;
+    average_alpha = alpha;
+    average_frames = 0;
+    avg_spectrum_primed = false;
+    power_spectrum = power_search || average != FFT_AVERAGE_NONE;
+    if (avg_spectrum != NULL)
+    {
+        memset(avg_spectrum, 0, (fft_length / 2 + 1) * sizeof(float));
+    }
+    return true;
+}
+
+bool FFT::setSpectrogram(int rows, float floor_db, float range_db)
+{
+    if (rows < 1 || range_db <= 0.0f)
+    {
+        return false;
+    }
+    // Like the other tables the ring is charged once; it can shrink but not grow
+    if (spectro_data == NULL)
+    {
+        spectro_data = (uint8_t *)allocate((size_t)rows * (fft_length / 2 + 1));
+        if (spectro_data == NULL)
+        {
+            return false;
+        }
+        spectro_capacity = rows;
+    }
+    else if (rows > spectro_capacity)
+    {
+        return false;
     }
 
-    arm_cfft_radix4_f32(scfft, fft_inputbuf);
+    spectro_rows = rows;
+    spectro_head = 0;
+    spectro_count = 0;
+    spectro_floor = floor_db;
+    spectro_range = range_db;
+    spectro_enabled = true;
+    return true;
+}
+
+void FFT::disableSpectrogram()
+{
+    // Keeps the buffer for a later setSpectrogram()
+    spectro_count = 0;
+    spectro_head = 0;
+    spectro_enabled = false;
+}
 
-    arm_cmplx_mag_f32(fft_inputbuf, fft_outputbuf, fft_length);
+int FFT::getSpectrogramRows()
+{
+    return spectro_count;
+}
 
-    find_main_freq(fft_outputbuf);
+const uint8_t *FFT::getSpectrogramRow(int age)
+{
+    if (age < 0 || age >= spectro_count)
+    {
+        return NULL;
+    }
+    int row = spectro_head - 1 - age;
+    row += row < 0 ? spectro_rows : 0;
+    return spectro_data + (size_t)row * (fft_length / 2 + 1);
+}
+
+int FFT::getSpectrogramSpans(const uint8_t **first, int *first_rows, const uint8_t **second, int *second_rows)
+{
+    int bins = fft_length / 2 + 1;
+    *second = NULL;
+    *second_rows = 0;
+    if (spectro_count == 0)
+    {
+        *first = NULL;
+        *first_rows = 0;
+        return 0;
+    }
+
+    // Until the ring wraps the history starts at row 0
+    int oldest = spectro_count < spectro_rows ? 0 : spectro_head;
+    *first = spectro_data + (size_t)oldest * bins;
+    if (oldest == 0)
+    {
+        *first_rows = spectro_count;
+        return 1;
+    }
+    *first_rows = spectro_rows - oldest;
+    *second = spectro_data;
+    *second_rows = spectro_head;
+    return 2;
+}
+
+float FFT::getSpectrogramFloor()
+{
+    return spectro_floor;
+}
+
+float FFT::getSpectrogramRange()
+{
+    return spectro_range;
+}
 
-    free(fft_outputbuf);
+bool FFT::setOverlap(FFT_Overlap overlap)
+{
+    if (overlap != FFT_OVERLAP_NONE && history == NULL)
+    {
+        history = (uint16_t *)allocate(fft_length * sizeof(uint16_t));
+        if (history == NULL)
+        {
+            return false;
+        }
+    }
+
+    this->overlap = overlap;
+    history_fill = 0;
+    return true;
+}
+
+void FFT::setPowerSearch(bool enable)
+{
+    power_search = enable;
+    power_spectrum = power_search || average != FFT_AVERAGE_NONE;
+}
+
+void FFT::setTracking(bool enable, int neighbourhood, int rescan_interval, float smoothing)
+{
+    tracking = enable;
+    tracker.neighbourhood = neighbourhood < 1 ? 1 : neighbourhood;
+    tracker.rescan_interval = rescan_interval < 1 ? 1 : rescan_interval;
+    tracker.smoothing = smoothing;
+    tracker.Reset();
+}
+
+// Only the first getPeakCount() entries are valid, and only while tracking
+const FFT_Track *FFT::getTracks()
+{
+    return tracks;
+}
+
+bool FFT::getTracking()
+{
+    return tracking;
+}
+
+void FFT::setUnits(FFT_Units units)
+{
+    this->units = units;
+}
+
+FFT_Average FFT::getAveraging()
+{
+    return average;
+}
+
+const float *FFT::getAveragedSpectrum()
+{
+    return average != FFT_AVERAGE_NONE ? avg_spectrum : NULL;
+}
+
+FFT_Mode FFT::getMode()
+{
+    return mode;
+}
+
+const FFT_Plan *FFT::getPlan()
+{
+    return &plan;
+}
+
+int FFT::getLength()
+{
+    return fft_length;
+}
+
+float FFT::getSampleRate()
+{
+    return sample_rate;
+}
+
+const float *FFT::getMainFrequencies()
+{
+    return main_Frequencies;
+}
+
+const FFT_Peak *FFT::getPeaks()
+{
+    return peaks;
+}
+
+int FFT::getPeakCount()
+{
+    return peak_count;
+}
+
+void FFT::setPeakCount(int count)
+{
+    if (count < 1)
+    {
+        count = 1;
+    }
+    else if (count > FFT_MAX_PEAKS)
+    {
+        count = FFT_MAX_PEAKS;
+    }
+    peak_finder.max_peaks = count;
+}
+
+void FFT::setPeakSpacing(int bins)
+{
+    peak_finder.min_spacing = bins < 1 ? 1 : bins;
+}
+
+void FFT::setInterpolation(FFT_Interp interp)
+{
+    peak_finder.interp = interp;
 }
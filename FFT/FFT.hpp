@@ -1,26 +1,259 @@
 #ifndef __FFT_H
 #define __FFT_H
 
-#include "main.h"
+#include "FFT_Backend.hpp"
 #include "string.h"
+#include "stdio.h"
 #include "stdlib.h"
 #include "errno.h"
-#include "arm_math.h"
+#include "math.h"
+#include "FFT_Peaks.hpp"
+#include "FFT_Tracker.hpp"
+#include "FFT_Window.hpp"
+#include "FFT_Analysis.hpp"
+#include "FFT_Cross.hpp"
 
+#define FFT_MAX_HEAP_BLOCKS 12
+#define FFT_ZOOM_MAX_DECIMATION 64
+#define FFT_ZOOM_TAPS_PER_PHASE 4      // FIR length is decimation * this
+
+enum FFT_Mode {
+    FFT_MODE_COMPLEX,   // CFFT over zero-imaginary samples
+    FFT_MODE_REAL       // real-input FFT, N/2+1 bins
+};
+
+enum FFT_Overlap {
+    FFT_OVERLAP_NONE,
+    FFT_OVERLAP_50,
+    FFT_OVERLAP_75
+};
+
+enum FFT_Average {
+    FFT_AVERAGE_NONE,
+    FFT_AVERAGE_LINEAR,         // mean of a block of frames, restarted after each report
+    FFT_AVERAGE_EXPONENTIAL,    // running avg += alpha * (|X|^2 - avg)
+    FFT_AVERAGE_PEAK_HOLD,      // max(|X|^2, decayed avg), alpha is the release rate
+    FFT_AVERAGE_MIN_HOLD        // min(|X|^2, decayed avg), alpha is the release rate
+};
+
+enum FFT_Units {
+    FFT_UNITS_LINEAR,   // peak amplitude |X|
+    FFT_UNITS_DB        // 20*log10(|X|)
+};
 
 class FFT {
 private:
-    arm_cfft_radix4_instance_f32* scfft;
+    FFT_Plan plan;
+    FFT_Mode mode;
     int  fft_length;
     float sample_rate;
     float* fft_inputbuf;
-    float main_Frequencies[5];
-    void find_main_freq(float* fft_outputbuf);
+    float* fft_spectrum;    // packed complex spectrum, aliases fft_inputbuf in complex mode
+    float* fft_outputbuf;   // N/2+1 magnitudes, aliases fft_inputbuf in real mode
+    float main_Frequencies[FFT_MAX_PEAKS];
+    FFT_Peak peaks[FFT_MAX_PEAKS];
+    int peak_count;
+    FFT_PeakFinder peak_finder;
+    FFT_Window window;
+    float* window_table;    // first N/2+1 coefficients, the periodic window is symmetric
+    bool dc_removal;
+
+    // Welch averaging of |X|^2, peaks are searched on avg_spectrum only
+    FFT_Average average;
+    float average_alpha;
+    int average_decimation;
+    int average_frames;
+    float* avg_spectrum;
+    bool avg_spectrum_primed;
+    bool power_spectrum;    // fft_outputbuf holds |X|^2 instead of |X|
+    bool power_search;      // user asked for |X|^2 ranking without averaging
+    FFT_Units units;
+    bool tracking;
+    FFT_PeakTracker tracker;
+    FFT_Track tracks[FFT_MAX_PEAKS];    // tracker output in reported units
+    FFT_Analysis analysis;
+    FFT_Cross cross;
+    FFT_Pitch pitch;
+    float pitch_min_lag;
+    float pitch_max_lag;
+    float* pitch_buf;       // real mode only: autocorrelation out of the inverse transform
+
+    // Overlapped framing for FFT_PUSH
+    FFT_Overlap overlap;
+    uint16_t* history;
+    int history_fill;
+
+    // Zoom FFT: mix the centre to DC, low-pass and decimate, then transform
+    // the decimated complex baseband at full length
+    bool zoom_enabled;
+    float zoom_centre;
+    int zoom_decimation;
+    int zoom_tap_count;
+    float* zoom_taps;
+    float* zoom_ring;       // complex delay line stored twice so the FIR reads it contiguously
+    int zoom_ring_pos;
+    float zoom_phase[2];    // NCO phasor e^(-j*phi)
+    float zoom_step[2];
+    int zoom_count;         // inputs since the last decimated output
+    int zoom_fill;          // decimated samples in the current frame
+    float* zoom_mag;        // N magnitudes, negative frequencies first
+    float zoom_offset;      // previous frame's mean, removed before mixing
+    uint32_t zoom_sum;
+    int zoom_sum_count;
+
+    // Spectrogram history: one row of N/2+1 quantised dB values per frame
+    bool spectro_enabled;
+    uint8_t* spectro_data;
+    int spectro_capacity;   // rows allocated by the first setSpectrogram()
+    int spectro_rows;
+    int spectro_head;       // row the next frame is written to
+    int spectro_count;
+    float spectro_floor;    // dB mapped to 0
+    float spectro_range;    // dB mapped to 255 above the floor
+
+    // Caller-owned arena, or nullptr when the buffers come from the heap
+    uint8_t* workspace;
+    size_t workspace_size;
+    size_t workspace_used;
+    void* heap_blocks[FFT_MAX_HEAP_BLOCKS];
+    int heap_count;
+
+    void* allocate(size_t bytes);
+    void init_buffers();
+    bool accumulate();
+    void find_main_freq(const float* spectrum, int first, int last, float bin_hz, float base_hz, bool power);
+    void zoom_frame();
+    void convert_pair(const uint16_t* adc_a, const uint16_t* adc_b, int stride);
+    void cross_phase(float bin_hz);
+    void record();
+    template <typename T>
+    void convert_frame(const T* samples, int stride);
+    float report_magnitude(float height, bool power);
 public:
-    FFT(int fft_length,float sample_rate);
+    FFT(int fft_length,float sample_rate, FFT_Mode mode = FFT_MODE_COMPLEX);
+    // Carve every buffer out of a static arena instead of the heap
+    FFT(int fft_length, float sample_rate, void* workspace, size_t workspace_size,
+        FFT_Mode mode = FFT_MODE_COMPLEX);
     ~FFT();
 
-    void FFT_PROCESS(uint16_t* adc_buffer);
+    // Bytes an arena must provide for the given length and mode. The arena
+    // needs no particular alignment; the padding is included.
+    static size_t Workspace_Size(int fft_length, FFT_Mode mode = FFT_MODE_COMPLEX);
+    // Whether the active backend can transform this length: any length in
+    // complex mode, any even length in real mode. Powers of two run on the
+    // native kernels, 2^a*3^b*5^c lengths (e.g. 2000, 3000) on mixed-radix
+    // stages, and anything else through Bluestein at roughly 3x the cost.
+    static bool Is_Supported(int fft_length, FFT_Mode mode = FFT_MODE_COMPLEX);
+    // Extra arena bytes setWindow() needs on top of Workspace_Size()
+    static size_t Window_Workspace_Size(int fft_length);
+    // Extra arena bytes setAveraging() and setOverlap() need
+    static size_t Averaging_Workspace_Size(int fft_length);
+    static size_t Overlap_Workspace_Size(int fft_length);
+    static size_t Zoom_Workspace_Size(int fft_length);
+    static size_t Spectrogram_Workspace_Size(int fft_length, int rows);
+    // Extra arena bytes setPitchRange() needs in real mode (0 in complex mode)
+    static size_t Pitch_Workspace_Size(int fft_length, FFT_Mode mode = FFT_MODE_REAL);
+
+    // Returns true when the peak list was updated
+    bool FFT_PROCESS(uint16_t* adc_buffer);
+    // Same pipeline for samples that are already floats, e.g. FFTFilter output
+    bool FFT_PROCESS(const float* samples);
+    // The FFT_PROCESS stages in order, public so they can be timed separately
+    void convert(uint16_t* adc_buffer);
+    // Reads every `stride`-th sample, e.g. one channel of an interleaved scan
+    void convert(const uint16_t* adc_buffer, int stride);
+    void convert(const float* samples, int stride);
+    void transform();
+    void magnitude();
+    bool search();
+    // Feeds getHopLength() new samples; frames overlap by the configured amount
+    bool FFT_PUSH(uint16_t* samples);
+    int getHopLength();
+    // Feeds raw samples to the zoom stage; true when a zoomed frame produced
+    // new peaks. Shares the input buffer with FFT_PROCESS.
+    bool FFT_ZOOM_PUSH(uint16_t* samples, int count);
+    // Complex mode only: both channels go through one transform as re + j*im
+    // and are separated afterwards. Peaks are searched on |X * conj(Y)|, and
+    // each gets the phase of A relative to B. For simultaneous dual-ADC
+    // scans pass the same buffer offset by one with stride 2.
+    bool FFT_CROSS_PROCESS(const uint16_t* adc_a, const uint16_t* adc_b, int stride = 1);
+    const FFT_Cross* getCross();
+    // X * conj(Y) for bins 0..N/2 as interleaved complex; overwritten by the
+    // next transform
+    const float* getCrossSpectrum();
+    FFT_Mode getMode();
+    // The transform plan, for stages such as FFTFilter that reuse it
+    const FFT_Plan* getPlan();
+    int getLength();
+    float getSampleRate();
+    const float* getMainFrequencies();
+    const FFT_Peak* getPeaks();
+    int getPeakCount();
+    // THD, SNR, SINAD and SFDR of the strongest tone in the last spectrum
+    // (the averaged one when averaging is on), harmonics 2..`harmonics`.
+    // False when there is no tone to measure.
+    bool Analyze(int harmonics = 5);
+    const FFT_Analysis* getAnalysis();
+    // Fundamentals searched by EstimatePitch(). Required before the first
+    // estimate in real mode, where it allocates the autocorrelation buffer.
+    bool setPitchRange(float min_hz, float max_hz);
+    // Autocorrelation of the last spectrum (the averaged one when averaging
+    // is on) by one inverse transform of |X|^2, then the first lag whose
+    // peak is within 10% of the strongest. Reuses the transform input
+    // buffer, so run it after FFT_PROCESS and before the next convert().
+    // False when there is no periodicity in range or no buffer yet.
+    bool EstimatePitch();
+    const FFT_Pitch* getPitch();
+
+    // Number of peaks kept per frame, 1..FFT_MAX_PEAKS
+    void setPeakCount(int count);
+    void setPeakSpacing(int bins);
+    void setInterpolation(FFT_Interp interp);
+    // Builds the coefficient table once; false if it cannot be allocated
+    bool setWindow(FFT_Window window);
+    FFT_Window getWindow();
+    // Rank peaks on |X|^2 and take the square root of the reported peaks
+    // only, skipping the per-bin sqrt of the magnitude stage
+    void setPowerSearch(bool enable);
+    // Follow peaks across frames instead of rescanning every bin; the peak
+    // list then carries the smoothed track frequencies
+    void setTracking(bool enable, int neighbourhood = 3, int rescan_interval = 16, float smoothing = 0.5f);
+    const FFT_Track* getTracks();
+    bool getTracking();
+    // Units of the peak magnitudes and FFT_Analysis::amplitude
+    void setUnits(FFT_Units units);
+    // Subtract the frame mean during sample conversion
+    void setDCRemoval(bool enable);
+    // Averages the power spectrum over frames in one persistent buffer and
+    // searches peaks every `decimation` frames. alpha is the exponential
+    // weight, or the hold modes' release per frame (0 holds forever).
+    bool setAveraging(FFT_Average average, int decimation, float alpha = 0.25f);
+    FFT_Average getAveraging();
+    bool setOverlap(FFT_Overlap overlap);
+    // Averaged |X|^2 for bins 0..N/2, or nullptr when averaging is off
+    const float* getAveragedSpectrum();
+    // Keeps the last `rows` spectra of FFT_PROCESS as 8-bit values, 0..255
+    // spanning floor_db..floor_db + range_db in the dB of setUnits(). The
+    // buffer is allocated on the first call only; later calls may not ask
+    // for more rows. Clears the history.
+    bool setSpectrogram(int rows, float floor_db, float range_db);
+    void disableSpectrogram();
+    int getSpectrogramRows();
+    // Row `age` frames back (0 is the newest), N/2+1 bytes, or nullptr.
+    // Points into the ring, so it is only valid until that row is reused.
+    const uint8_t* getSpectrogramRow(int age);
+    // The history oldest first as up to two contiguous runs of rows, for
+    // exporting without a copy; returns the number of runs
+    int getSpectrogramSpans(const uint8_t** first, int* first_rows, const uint8_t** second, int* second_rows);
+    float getSpectrogramFloor();
+    float getSpectrogramRange();
+    // Complex mode only: resolves centre +/- sample_rate / (2 * decimation)
+    // with bins of sample_rate / (decimation * fft_length)
+    bool setZoom(float centre, int decimation);
+    void disableZoom();
+    // N zoomed magnitudes (|X|^2 with power search) from centre - span/2
+    // upwards, or nullptr
+    const float* getZoomSpectrum();
 };
 
 #endif
\ No newline at end of file
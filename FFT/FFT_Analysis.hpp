@@ -0,0 +1,35 @@
+#ifndef __FFT_ANALYSIS_H
+#define __FFT_ANALYSIS_H
+
+#define FFT_MAX_HARMONICS 10    // highest harmonic order Analyze() measures
+
+struct FFT_Harmonic {
+    int order;          // 2 for the second harmonic, ...
+    float frequency;    // Hz, after folding into 0..sample_rate/2
+    float level;        // dBc
+};
+
+// Single-tone quality figures from one spectrum. Tone powers are summed
+// over the window's main lobe, so ratios are independent of the window.
+struct FFT_Analysis {
+    float fundamental;          // Hz, interpolated
+    float amplitude;            // fundamental peak height, same scale as getPeaks()
+    int harmonic_count;
+    FFT_Harmonic harmonics[FFT_MAX_HARMONICS - 1];
+    float noise_floor;          // mean noise power per bin, dBc
+    float thd;                  // dBc
+    float snr;                  // dB, harmonics excluded
+    float sinad;                // dB
+    float sfdr;                 // dBc, fundamental peak to largest other bin
+    float enob;                 // bits, from sinad
+};
+
+// Fundamental from the autocorrelation peak, which is found even when a
+// harmonic is stronger than the fundamental or the fundamental is missing
+struct FFT_Pitch {
+    float frequency;    // Hz, sample_rate / lag
+    float lag;          // samples, interpolated
+    float confidence;   // 0..1, autocorrelation at the lag over that at 0, window taper removed
+};
+
+#endif
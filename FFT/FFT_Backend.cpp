@@ -0,0 +1,908 @@
+#include "FFT_Backend.hpp"
+#include <math.h>
+#include <string.h>
+
+#if !FFT_BACKEND_CMSIS
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE3__)
+#include <pmmintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define FFT_BACKEND_NEON 1
+#endif
+#endif
+
+#define FFT_BACKEND_ALIGN 8
+#define FFT_PLAN_MAX_LENGTH 65536
+
+static bool is_power_of_2(int n)
+{
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+static size_t align_up(size_t bytes)
+{
+    return (bytes + FFT_BACKEND_ALIGN - 1) & ~(size_t)(FFT_BACKEND_ALIGN - 1);
+}
+
+// Carves plan memory in order; a measuring pass only counts bytes, so
+// FFT_Plan_Size and FFT_Plan_Init share one layout. Measuring is explicit
+// because CMSIS-native plans need no memory and get a NULL base when built.
+struct Plan_Memory {
+    uint8_t *base;
+    size_t used;
+    bool measuring;
+};
+
+static void *take(Plan_Memory *memory, size_t bytes)
+{
+    void *block = !memory->measuring ? memory->base + memory->used : NULL;
+    memory->used += align_up(bytes);
+    return block;
+}
+
+static void conjugate(float *x, int n, float scale)
+{
+    for (int i = 0; i < n; i++)
+    {
+        x[2 * i] *= scale;
+        x[2 * i + 1] *= -scale;
+    }
+}
+
+#if FFT_BACKEND_CMSIS
+
+static bool native_complex(int n)
+{
+    return is_power_of_2(n) && n >= 16 && n <= 4096;
+}
+
+static bool native_real(int n)
+{
+    return is_power_of_2(n) && n >= 32 && n <= 4096;
+}
+
+static void native_init(FFT_Plan *plan, Plan_Memory *memory)
+{
+    if (memory->measuring)
+    {
+        return;
+    }
+    if (plan->real)
+    {
+        arm_rfft_fast_init_f32(&plan->rfft, plan->length);
+        return;
+    }
+    switch (plan->length)
+    {
+    case 16:    plan->cfft = &arm_cfft_sR_f32_len16;    break;
+    case 32:    plan->cfft = &arm_cfft_sR_f32_len32;    break;
+    case 64:    plan->cfft = &arm_cfft_sR_f32_len64;    break;
+    case 128:   plan->cfft = &arm_cfft_sR_f32_len128;   break;
+    case 256:   plan->cfft = &arm_cfft_sR_f32_len256;   break;
+    case 512:   plan->cfft = &arm_cfft_sR_f32_len512;   break;
+    case 1024:  plan->cfft = &arm_cfft_sR_f32_len1024;  break;
+    case 2048:  plan->cfft = &arm_cfft_sR_f32_len2048;  break;
+    default:    plan->cfft = &arm_cfft_sR_f32_len4096;  break;
+    }
+}
+
+static void native_forward(const FFT_Plan *plan, float *data)
+{
+    arm_cfft_f32(plan->cfft, data, 0, 1);
+}
+
+
+static void native_inverse(const FFT_Plan *plan, float *data)
+{
+    arm_cfft_f32(plan->cfft, data, 1, 1);
+}
+
+void FFT_Magnitude(const float *data, float *mag, int count)
+{
+    arm_cmplx_mag_f32(data, mag, count);
+}
+
+void FFT_Magnitude_Squared(const float *data, float *mag, int count)
+{
+    arm_cmplx_mag_squared_f32(data, mag, count);
+}
+
+// CMSIS-DSP has no fused form of these; the loops are simple enough for
+// the compiler to unroll, or vectorise with Helium
+void FFT_Smooth(float *avg, const float *x, float alpha, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        avg[i] += alpha * (x[i] - avg[i]);
+    }
+}
+
+void FFT_Peak_Hold(float *avg, const float *x, float alpha, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        float s = avg[i] + alpha * (x[i] - avg[i]);
+        avg[i] = x[i] > s ? x[i] : s;
+    }
+}
+
+void FFT_Min_Hold(float *avg, const float *x, float alpha, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        float s = avg[i] + alpha * (x[i] - avg[i]);
+        avg[i] = x[i] < s ? x[i] : s;
+    }
+}
+
+#else
+
+static bool native_complex(int n)
+{
+    return is_power_of_2(n) && n >= 2 && n <= 32768;
+}
+
+// Real input always goes through the split path here
+static bool native_real(int)
+{
+    return false;
+}
+
+static void native_init(FFT_Plan *plan, Plan_Memory *memory)
+{
+    int n = plan->length;
+    plan->twiddle = (float *)take(memory, (n - 1) * 2 * sizeof(float));
+    plan->bitrev = (uint16_t *)take(memory, n * sizeof(uint16_t));
+    if (memory->measuring)
+    {
+        return;
+    }
+
+    // Stage tables are contiguous so each butterfly group streams through them
+    for (int half = 1; half < n; half <<= 1)
+    {
+        float *w = plan->twiddle + 2 * (half - 1);
+        for (int k = 0; k < half; k++)
+        {
+            double x = 3.14159265358979323846 * k / half;
+            w[2 * k] = (float)cos(x);
+            w[2 * k + 1] = (float)-sin(x);
+        }
+    }
+
+    for (int i = 0, j = 0; i < n; i++)
+    {
+        plan->bitrev[i] = (uint16_t)j;
+        int bit = n >> 1;
+        while (j & bit)
+        {
+            j ^= bit;
+            bit >>= 1;
+        }
+        j |= bit;
+    }
+}
+
+// Iterative radix-2 decimation in time over n interleaved complex values
+static void cfft_radix2(const FFT_Plan *plan, float *x, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        int j = plan->bitrev[i];
+        if (i < j)
+        {
+            float re = x[2 * i];
+            float im = x[2 * i + 1];
+            x[2 * i] = x[2 * j];
+            x[2 * i + 1] = x[2 * j + 1];
+            x[2 * j] = re;
+            x[2 * j + 1] = im;
+        }
+    }
+
+    for (int i = 0; i < n; i += 2)
+    {
+        float *a = x + 2 * i;
+        float re = a[2];
+        float im = a[3];
+        a[2] = a[0] - re;
+        a[3] = a[1] - im;
+        a[0] += re;
+        a[1] += im;
+    }
+
+    for (int half = 2; half < n; half <<= 1)
+    {
+        const float *w = plan->twiddle + 2 * (half - 1);
+        for (int start = 0; start < n; start += 2 * half)
+        {
+            float *a = x + 2 * start;
+            float *b = a + 2 * half;
+            int k = 0;
+#if defined(__AVX__)
+            for (; k + 4 <= half; k += 4)
+            {
+                __m256 bv = _mm256_loadu_ps(b + 2 * k);
+                __m256 wv = _mm256_loadu_ps(w + 2 * k);
+                __m256 swapped = _mm256_permute_ps(bv, 0xB1);
+                __m256 t = _mm256_addsub_ps(_mm256_mul_ps(bv, _mm256_moveldup_ps(wv)),
+                                            _mm256_mul_ps(swapped, _mm256_movehdup_ps(wv)));
+                __m256 av = _mm256_loadu_ps(a + 2 * k);
+                _mm256_storeu_ps(a + 2 * k, _mm256_add_ps(av, t));
+                _mm256_storeu_ps(b + 2 * k, _mm256_sub_ps(av, t));
+            }
+#endif
+#if defined(__SSE3__)
+            for (; k + 2 <= half; k += 2)
+            {
+                __m128 bv = _mm_loadu_ps(b + 2 * k);
+                __m128 wv = _mm_loadu_ps(w + 2 * k);
+                __m128 swapped = _mm_shuffle_ps(bv, bv, _MM_SHUFFLE(2, 3, 0, 1));
+                __m128 t = _mm_addsub_ps(_mm_mul_ps(bv, _mm_moveldup_ps(wv)),
+                                         _mm_mul_ps(swapped, _mm_movehdup_ps(wv)));
+                __m128 av = _mm_loadu_ps(a + 2 * k);
+                _mm_storeu_ps(a + 2 * k, _mm_add_ps(av, t));
+                _mm_storeu_ps(b + 2 * k, _mm_sub_ps(av, t));
+            }
+#endif
+#if defined(FFT_BACKEND_NEON)
+            for (; k + 4 <= half; k += 4)
+            {
+                float32x4x2_t bv = vld2q_f32(b + 2 * k);
+                float32x4x2_t wv = vld2q_f32(w + 2 * k);
+                float32x4x2_t av = vld2q_f32(a + 2 * k);
+                float32x4_t tr = vmlsq_f32(vmulq_f32(bv.val[0], wv.val[0]), bv.val[1], wv.val[1]);
+                float32x4_t ti = vmlaq_f32(vmulq_f32(bv.val[0], wv.val[1]), bv.val[1], wv.val[0]);
+                float32x4x2_t out;
+                out.val[0] = vaddq_f32(av.val[0], tr);
+                out.val[1] = vaddq_f32(av.val[1], ti);
+                vst2q_f32(a + 2 * k, out);
+                out.val[0] = vsubq_f32(av.val[0], tr);
+                out.val[1] = vsubq_f32(av.val[1], ti);
+                vst2q_f32(b + 2 * k, out);
+            }
+#endif
+            for (; k < half; k++)
+            {
+                float wr = w[2 * k];
+                float wi = w[2 * k + 1];
+                float tr = b[2 * k] * wr - b[2 * k + 1] * wi;
+                float ti = b[2 * k] * wi + b[2 * k + 1] * wr;
+                b[2 * k] = a[2 * k] - tr;
+                b[2 * k + 1] = a[2 * k + 1] - ti;
+                a[2 * k] += tr;
+                a[2 * k + 1] += ti;
+            }
+        }
+    }
+}
+
+static void native_forward(const FFT_Plan *plan, float *data)
+{
+    cfft_radix2(plan, data, plan->length);
+}
+
+static void native_inverse(const FFT_Plan *plan, float *data)
+{
+    int n = plan->length;
+    conjugate(data, n, 1.0f);
+    cfft_radix2(plan, data, n);
+    conjugate(data, n, 1.0f / n);
+}
+
+void FFT_Magnitude(const float *data, float *mag, int count)
+{
+    int i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 lo = _mm256_loadu_ps(data + 2 * i);
+        __m256 hi = _mm256_loadu_ps(data + 2 * i + 8);
+        __m256 re = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 im = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 m = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(re, re), _mm256_mul_ps(im, im)));
+        // The in-lane shuffles leave the pairs of results out of order
+        m = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(m), _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(mag + i, m);
+    }
+#endif
+#if defined(__SSE3__)
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 lo = _mm_loadu_ps(data + 2 * i);
+        __m128 hi = _mm_loadu_ps(data + 2 * i + 4);
+        __m128 re = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(mag + i, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im))));
+    }
+#endif
+#if defined(FFT_BACKEND_NEON)
+    for (; i + 4 <= count; i += 4)
+    {
+        float32x4x2_t v = vld2q_f32(data + 2 * i);
+        float32x4_t p = vmlaq_f32(vmulq_f32(v.val[0], v.val[0]), v.val[1], v.val[1]);
+        vst1q_f32(mag + i, vsqrtq_f32(p));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        float re = data[2 * i];
+        float im = data[2 * i + 1];
+        mag[i] = sqrtf(re * re + im * im);
+    }
+}
+
+void FFT_Magnitude_Squared(const float *data, float *mag, int count)
+{
+    int i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 lo = _mm256_loadu_ps(data + 2 * i);
+        __m256 hi = _mm256_loadu_ps(data + 2 * i + 8);
+        __m256 re = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 im = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 m = _mm256_add_ps(_mm256_mul_ps(re, re), _mm256_mul_ps(im, im));
+        m = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(m), _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(mag + i, m);
+    }
+#endif
+#if defined(__SSE3__)
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 lo = _mm_loadu_ps(data + 2 * i);
+        __m128 hi = _mm_loadu_ps(data + 2 * i + 4);
+        __m128 re = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(mag + i, _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)));
+    }
+#endif
+#if defined(FFT_BACKEND_NEON)
+    for (; i + 4 <= count; i += 4)
+    {
+        float32x4x2_t v = vld2q_f32(data + 2 * i);
+        vst1q_f32(mag + i, vmlaq_f32(vmulq_f32(v.val[0], v.val[0]), v.val[1], v.val[1]));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        float re = data[2 * i];
+        float im = data[2 * i + 1];
+        mag[i] = re * re + im * im;
+    }
+}
+
+enum Hold_Kind {
+    HOLD_NONE,
+    HOLD_MAX,
+    HOLD_MIN
+};
+
+// One kernel for all three updates; HOLD is a constant, so each
+// instantiation keeps a branch-free inner loop
+template <int HOLD>
+static void smooth(float *avg, const float *x, float alpha, int count)
+{
+    int i = 0;
+#if defined(__AVX__)
+    __m256 a8 = _mm256_set1_ps(alpha);
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 v = _mm256_loadu_ps(avg + i);
+        __m256 xv = _mm256_loadu_ps(x + i);
+        __m256 s = _mm256_add_ps(v, _mm256_mul_ps(a8, _mm256_sub_ps(xv, v)));
+        if (HOLD == HOLD_MAX)  s = _mm256_max_ps(s, xv);
+        if (HOLD == HOLD_MIN)  s = _mm256_min_ps(s, xv);
+        _mm256_storeu_ps(avg + i, s);
+    }
+#endif
+#if defined(__SSE3__)
+    __m128 a4 = _mm_set1_ps(alpha);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 v = _mm_loadu_ps(avg + i);
+        __m128 xv = _mm_loadu_ps(x + i);
+        __m128 s = _mm_add_ps(v, _mm_mul_ps(a4, _mm_sub_ps(xv, v)));
+        if (HOLD == HOLD_MAX)  s = _mm_max_ps(s, xv);
+        if (HOLD == HOLD_MIN)  s = _mm_min_ps(s, xv);
+        _mm_storeu_ps(avg + i, s);
+    }
+#endif
+#if defined(FFT_BACKEND_NEON)
+    float32x4_t a4 = vdupq_n_f32(alpha);
+    for (; i + 4 <= count; i += 4)
+    {
+        float32x4_t v = vld1q_f32(avg + i);
+        float32x4_t xv = vld1q_f32(x + i);
+        float32x4_t s = vmlaq_f32(v, a4, vsubq_f32(xv, v));
+        if (HOLD == HOLD_MAX)  s = vmaxq_f32(s, xv);
+        if (HOLD == HOLD_MIN)  s = vminq_f32(s, xv);
+        vst1q_f32(avg + i, s);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        float s = avg[i] + alpha * (x[i] - avg[i]);
+        if (HOLD == HOLD_MAX)  s = x[i] > s ? x[i] : s;
+        if (HOLD == HOLD_MIN)  s = x[i] < s ? x[i] : s;
+        avg[i] = s;
+    }
+}
+
+void FFT_Smooth(float *avg, const float *x, float alpha, int count)
+{
+    smooth<HOLD_NONE>(avg, x, alpha, count);
+}
+
+void FFT_Peak_Hold(float *avg, const float *x, float alpha, int count)
+{
+    smooth<HOLD_MAX>(avg, x, alpha, count);
+}
+
+void FFT_Min_Hold(float *avg, const float *x, float alpha, int count)
+{
+    smooth<HOLD_MIN>(avg, x, alpha, count);
+}
+
+#endif
+
+// Radix-4 first so most of the work runs in the cheapest butterflies
+static bool factorise(int n, FFT_Plan *plan)
+{
+    static const uint8_t radices[] = {4, 2, 3, 5};
+    plan->factor_count = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        while (n % radices[i] == 0)
+        {
+            plan->factors[plan->factor_count++] = radices[i];
+            n /= radices[i];
+        }
+    }
+    return n == 1;
+}
+
+// Stage s with radix R follows stages of total span L: entries (k, r) for
+// k < L, 1 <= r < R hold e^(-j*2*pi*k*r / (L*R))
+static void mixed_init(FFT_Plan *plan, Plan_Memory *memory)
+{
+    int n = plan->length;
+    int entries = 0;
+    for (int s = 0, span = 1; s < plan->factor_count; span *= plan->factors[s++])
+    {
+        entries += span * (plan->factors[s] - 1);
+    }
+    plan->stage_twiddle = (float *)take(memory, entries * 2 * sizeof(float));
+    plan->scratch = (float *)take(memory, n * 2 * sizeof(float));
+    if (memory->measuring)
+    {
+        return;
+    }
+
+    float *w = plan->stage_twiddle;
+    for (int s = 0, span = 1; s < plan->factor_count; span *= plan->factors[s++])
+    {
+        int radix = plan->factors[s];
+        for (int k = 0; k < span; k++)
+        {
+            for (int r = 1; r < radix; r++)
+            {
+                double x = -6.28318530717958647692 * k * r / ((double)span * radix);
+                *w++ = (float)cos(x);
+                *w++ = (float)sin(x);
+            }
+        }
+    }
+}
+
+// In-place forward DFT of 2..5 interleaved complex values
+static void butterfly(float *v, int radix)
+{
+    switch (radix)
+    {
+    case 2:
+    {
+        float re = v[2], im = v[3];
+        v[2] = v[0] - re;
+        v[3] = v[1] - im;
+        v[0] += re;
+        v[1] += im;
+        break;
+    }
+    case 3:
+    {
+        const float s = 0.86602540378f;
+        float ar = v[2] + v[4], ai = v[3] + v[5];
+        float dr = s * (v[2] - v[4]), di = s * (v[3] - v[5]);
+        float mr = v[0] - 0.5f * ar, mi = v[1] - 0.5f * ai;
+        v[0] += ar;
+        v[1] += ai;
+        v[2] = mr + di;
+        v[3] = mi - dr;
+        v[4] = mr - di;
+        v[5] = mi + dr;
+        break;
+    }
+    case 4:
+    {
+        float sr = v[0] + v[4], si = v[1] + v[5];
+        float dr = v[0] - v[4], di = v[1] - v[5];
+        float tr = v[2] + v[6], ti = v[3] + v[7];
+        float ur = v[2] - v[6], ui = v[3] - v[7];
+        v[0] = sr + tr;
+        v[1] = si + ti;
+        v[2] = dr + ui;
+        v[3] = di - ur;
+        v[4] = sr - tr;
+        v[5] = si - ti;
+        v[6] = dr - ui;
+        v[7] = di + ur;
+        break;
+    }
+    default:
+    {
+        const float c1 = 0.30901699437f, c2 = -0.80901699437f;
+        const float s1 = 0.95105651630f, s2 = 0.58778525229f;
+        float a1r = v[2] + v[8], a1i = v[3] + v[9];
+        float b1r = v[2] - v[8], b1i = v[3] - v[9];
+        float a2r = v[4] + v[6], a2i = v[5] + v[7];
+        float b2r = v[4] - v[6], b2i = v[5] - v[7];
+        float p1r = v[0] + c1 * a1r + c2 * a2r, p1i = v[1] + c1 * a1i + c2 * a2i;
+        float p2r = v[0] + c2 * a1r + c1 * a2r, p2i = v[1] + c2 * a1i + c1 * a2i;
+        float q1r = s1 * b1r + s2 * b2r, q1i = s1 * b1i + s2 * b2i;
+        float q2r = s2 * b1r - s1 * b2r, q2i = s2 * b1i - s1 * b2i;
+        v[0] += a1r + a2r;
+        v[1] += a1i + a2i;
+        v[2] = p1r + q1i;
+        v[3] = p1i - q1r;
+        v[8] = p1r - q1i;
+        v[9] = p1i + q1r;
+        v[4] = p2r + q2i;
+        v[5] = p2i - q2r;
+        v[6] = p2r - q2i;
+        v[7] = p2i + q2r;
+        break;
+    }
+    }
+}
+
+// Stockham autosort: every stage reads with stride n / R and writes in
+// natural order, so there is no bit reversal for mixed radices
+static void mixed_forward(const FFT_Plan *plan, float *data)
+{
+    int n = plan->length;
+    float *src = data;
+    float *dst = plan->scratch;
+    const float *w = plan->stage_twiddle;
+    float v[10];
+
+    for (int s = 0, span = 1; s < plan->factor_count; span *= plan->factors[s++])
+    {
+        int radix = plan->factors[s];
+        int stride = n / radix;
+        for (int group = 0; group < stride; group += span)
+        {
+            const float *in = src + 2 * group;
+            float *out = dst + 2 * group * radix;
+            for (int k = 0; k < span; k++)
+            {
+                const float *t = w + 2 * k * (radix - 1);
+                v[0] = in[2 * k];
+                v[1] = in[2 * k + 1];
+                for (int r = 1; r < radix; r++)
+                {
+                    float re = in[2 * (k + r * stride)];
+                    float im = in[2 * (k + r * stride) + 1];
+                    v[2 * r] = re * t[2 * r - 2] - im * t[2 * r - 1];
+                    v[2 * r + 1] = re * t[2 * r - 1] + im * t[2 * r - 2];
+                }
+                butterfly(v, radix);
+                for (int r = 0; r < radix; r++)
+                {
+                    out[2 * (k + r * span)] = v[2 * r];
+                    out[2 * (k + r * span) + 1] = v[2 * r + 1];
+                }
+            }
+        }
+        w += 2 * span * (radix - 1);
+        float *swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    if (src != data)
+    {
+        memcpy(data, src, n * 2 * sizeof(float));
+    }
+}
+
+static void plan_build(FFT_Plan *plan, int length, bool real, Plan_Memory *memory);
+
+// Nested plans live in the same memory; a measuring pass builds them on the stack
+static FFT_Plan *inner_build(FFT_Plan *scratch_plan, int length, Plan_Memory *memory)
+{
+    FFT_Plan *inner = (FFT_Plan *)take(memory, sizeof(FFT_Plan));
+    if (inner == NULL)
+    {
+        inner = scratch_plan;
+    }
+    plan_build(inner, length, false, memory);
+    return inner;
+}
+
+// X[k] = c[k] * sum x[n] c[n] conj(c[k - n]) with c[n] = e^(-j*pi*n^2/N),
+// a circular convolution over M >= 2N - 1 points done with a power-of-two plan
+static void bluestein_init(FFT_Plan *plan, Plan_Memory *memory)
+{
+    int n = plan->length;
+    int m = 1;
+    while (m < 2 * n - 1)
+    {
+        m <<= 1;
+    }
+    plan->chirp = (float *)take(memory, n * 2 * sizeof(float));
+    plan->chirp_spectrum = (float *)take(memory, m * 2 * sizeof(float));
+    plan->work = (float *)take(memory, m * 2 * sizeof(float));
+    FFT_Plan measuring;
+    plan->inner = inner_build(&measuring, m, memory);
+    if (memory->measuring)
+    {
+        return;
+    }
+
+    // n^2 mod 2N keeps the angle exact for large n
+    for (int i = 0; i < n; i++)
+    {
+        long long q = ((long long)i * i) % (2LL * n);
+        double x = 3.14159265358979323846 * q / n;
+        plan->chirp[2 * i] = (float)cos(x);
+        plan->chirp[2 * i + 1] = (float)-sin(x);
+    }
+
+    float *b = plan->chirp_spectrum;
+    memset(b, 0, m * 2 * sizeof(float));
+    for (int i = 0; i < n; i++)
+    {
+        b[2 * i] = plan->chirp[2 * i];
+        b[2 * i + 1] = -plan->chirp[2 * i + 1];
+        if (i > 0)
+        {
+            b[2 * (m - i)] = b[2 * i];
+            b[2 * (m - i) + 1] = b[2 * i + 1];
+        }
+    }
+    FFT_Forward_Complex(plan->inner, b);
+    for (int i = 0; i < 2 * m; i++)
+    {
+        b[i] /= m;
+    }
+}
+
+// The inverse transform is folded into the conjugations around a second
+// forward pass, and its 1/M into chirp_spectrum
+static void bluestein_forward(const FFT_Plan *plan, float *data)
+{
+    int n = plan->length;
+    int m = plan->inner->length;
+    const float *c = plan->chirp;
+    const float *b = plan->chirp_spectrum;
+    float *work = plan->work;
+
+    for (int i = 0; i < n; i++)
+    {
+        work[2 * i] = data[2 * i] * c[2 * i] - data[2 * i + 1] * c[2 * i + 1];
+        work[2 * i + 1] = data[2 * i] * c[2 * i + 1] + data[2 * i + 1] * c[2 * i];
+    }
+    memset(work + 2 * n, 0, (m - n) * 2 * sizeof(float));
+
+    FFT_Forward_Complex(plan->inner, work);
+    for (int i = 0; i < m; i++)
+    {
+        float re = work[2 * i] * b[2 * i] - work[2 * i + 1] * b[2 * i + 1];
+        float im = work[2 * i] * b[2 * i + 1] + work[2 * i + 1] * b[2 * i];
+        work[2 * i] = re;
+        work[2 * i + 1] = -im;
+    }
+    FFT_Forward_Complex(plan->inner, work);
+
+    for (int i = 0; i < n; i++)
+    {
+        float re = work[2 * i];
+        float im = -work[2 * i + 1];
+        data[2 * i] = re * c[2 * i] - im * c[2 * i + 1];
+        data[2 * i + 1] = re * c[2 * i + 1] + im * c[2 * i];
+    }
+}
+
+// Nested plans may exceed FFT_PLAN_MAX_LENGTH; Bluestein's convolution is
+// up to twice the outer length and always a power of two
+static void plan_build(FFT_Plan *plan, int length, bool real, Plan_Memory *memory)
+{
+    plan->length = length;
+    plan->real = real;
+    plan->complex_length = length;
+    plan->inner = NULL;
+    plan->split = NULL;
+    plan->factor_count = 0;
+    plan->stage_twiddle = NULL;
+    plan->scratch = NULL;
+    plan->chirp = NULL;
+    plan->chirp_spectrum = NULL;
+    plan->work = NULL;
+
+    if (real)
+    {
+        if (native_real(length))
+        {
+            plan->kind = FFT_PLAN_RADIX2;
+            native_init(plan, memory);
+            return;
+        }
+        plan->kind = FFT_PLAN_SPLIT;
+        plan->complex_length = length / 2;
+        plan->split = (float *)take(memory, length * sizeof(float));
+        FFT_Plan measuring;
+        plan->inner = inner_build(&measuring, length / 2, memory);
+        if (!memory->measuring)
+        {
+            for (int k = 0; k < length / 2; k++)
+            {
+                double x = 6.28318530717958647692 * k / length;
+                plan->split[2 * k] = (float)cos(x);
+                plan->split[2 * k + 1] = (float)-sin(x);
+            }
+        }
+        return;
+    }
+
+    if (native_complex(length))
+    {
+        plan->kind = FFT_PLAN_RADIX2;
+        native_init(plan, memory);
+    }
+    else if (factorise(length, plan))
+    {
+        plan->kind = FFT_PLAN_MIXED;
+        mixed_init(plan, memory);
+    }
+    else
+    {
+        plan->kind = FFT_PLAN_BLUESTEIN;
+        bluestein_init(plan, memory);
+    }
+}
+
+bool FFT_Plan_Supported(int length, bool real)
+{
+    if (real)
+    {
+        return length >= 4 && length % 2 == 0 && length <= FFT_PLAN_MAX_LENGTH;
+    }
+    return length >= 2 && length <= FFT_PLAN_MAX_LENGTH;
+}
+
+size_t FFT_Plan_Size(int length, bool real)
+{
+    if (!FFT_Plan_Supported(length, real))
+    {
+        return 0;
+    }
+    FFT_Plan plan;
+    Plan_Memory memory = {NULL, 0, true};
+    plan_build(&plan, length, real, &memory);
+    return memory.used;
+}
+
+bool FFT_Plan_Init(FFT_Plan *plan, int length, bool real, void *memory)
+{
+    plan->length = length;
+    plan->real = real;
+    if (!FFT_Plan_Supported(length, real) || (FFT_Plan_Size(length, real) > 0 && memory == NULL))
+    {
+        return false;
+    }
+    Plan_Memory carve = {(uint8_t *)memory, 0, false};
+    plan_build(plan, length, real, &carve);
+    return true;
+}
+
+void FFT_Forward_Complex(const FFT_Plan *plan, float *data)
+{
+    switch (plan->kind)
+    {
+    case FFT_PLAN_MIXED:
+        mixed_forward(plan, data);
+        break;
+    case FFT_PLAN_BLUESTEIN:
+        bluestein_forward(plan, data);
+        break;
+    default:
+        native_forward(plan, data);
+        break;
+    }
+}
+
+// IFFT(x) = conj(FFT(conj(x))) / N
+void FFT_Inverse_Complex(const FFT_Plan *plan, float *data)
+{
+    if (plan->kind == FFT_PLAN_RADIX2)
+    {
+        native_inverse(plan, data);
+        return;
+    }
+    int n = plan->length;
+    conjugate(data, n, 1.0f);
+    FFT_Forward_Complex(plan, data);
+    conjugate(data, n, 1.0f / n);
+}
+
+// The N real samples are transformed as N/2 complex values z = even + j*odd,
+// then split: X[k] = E[k] + W^k * O[k] with E, O recovered from Z[k], Z[N/2-k]
+void FFT_Forward_Real(const FFT_Plan *plan, float *in, float *out)
+{
+#if FFT_BACKEND_CMSIS
+    if (plan->kind == FFT_PLAN_RADIX2)
+    {
+        arm_rfft_fast_f32(const_cast<arm_rfft_fast_instance_f32 *>(&plan->rfft), in, out, 0);
+        return;
+    }
+#endif
+    int half = plan->complex_length;
+    FFT_Forward_Complex(plan->inner, in);
+
+    out[0] = in[0] + in[1];
+    out[1] = in[0] - in[1];
+    for (int k = 1; k < half; k++)
+    {
+        float ar = in[2 * k];
+        float ai = in[2 * k + 1];
+        float br = in[2 * (half - k)];
+        float bi = -in[2 * (half - k) + 1];
+        float er = 0.5f * (ar + br);
+        float ei = 0.5f * (ai + bi);
+        float orr = 0.5f * (ai - bi);
+        float oi = -0.5f * (ar - br);
+        float wr = plan->split[2 * k];
+        float wi = plan->split[2 * k + 1];
+        out[2 * k] = er + wr * orr - wi * oi;
+        out[2 * k + 1] = ei + wr * oi + wi * orr;
+    }
+}
+
+void FFT_Inverse_Real(const FFT_Plan *plan, float *in, float *out)
+{
+#if FFT_BACKEND_CMSIS
+    if (plan->kind == FFT_PLAN_RADIX2)
+    {
+        arm_rfft_fast_f32(const_cast<arm_rfft_fast_instance_f32 *>(&plan->rfft), in, out, 1);
+        return;
+    }
+#endif
+    int half = plan->complex_length;
+
+    // Z[k] = E[k] + j*O[k], E = (X[k] + X*[N/2-k]) / 2, O = (X[k] - X*[N/2-k]) / (2 W^k)
+    out[0] = 0.5f * (in[0] + in[1]);
+    out[1] = 0.5f * (in[0] - in[1]);
+    for (int k = 1; k < half; k++)
+    {
+        float ar = in[2 * k];
+        float ai = in[2 * k + 1];
+        float br = in[2 * (half - k)];
+        float bi = -in[2 * (half - k) + 1];
+        float er = 0.5f * (ar + br);
+        float ei = 0.5f * (ai + bi);
+        float dr = 0.5f * (ar - br);
+        float di = 0.5f * (ai - bi);
+        float wr = plan->split[2 * k];
+        float wi = -plan->split[2 * k + 1];
+        float orr = dr * wr - di * wi;
+        float oi = dr * wi + di * wr;
+        out[2 * k] = er - oi;
+        out[2 * k + 1] = ei + orr;
+    }
+
+    FFT_Inverse_Complex(plan->inner, out);
+}
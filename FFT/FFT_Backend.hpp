@@ -0,0 +1,87 @@
+#ifndef __FFT_BACKEND_H
+#define __FFT_BACKEND_H
+
+// Transform backend selection. Cortex-M builds use CMSIS-DSP; anything else
+// (or -DFFT_BACKEND_PORTABLE) uses the portable kernels, vectorised with
+// SSE3/AVX or NEON when the compiler targets them.
+#if !defined(FFT_BACKEND_CMSIS)
+#if !defined(FFT_BACKEND_PORTABLE) && \
+    (defined(USE_HAL_DRIVER) || (defined(__ARM_ARCH_PROFILE) && __ARM_ARCH_PROFILE == 'M'))
+#define FFT_BACKEND_CMSIS 1
+#else
+#define FFT_BACKEND_CMSIS 0
+#endif
+#endif
+
+#if FFT_BACKEND_CMSIS
+#include "main.h"
+#include "arm_math.h"
+#include "arm_const_structs.h"
+#else
+#include <stdint.h>
+#include <stddef.h>
+typedef int16_t q15_t;
+#endif
+
+#define FFT_PLAN_MAX_FACTORS 32
+
+enum FFT_Plan_Kind {
+    FFT_PLAN_RADIX2,        // power of two on the native kernels
+    FFT_PLAN_MIXED,         // 2^a * 3^b * 5^c, Stockham autosort with radix 2/3/4/5 stages
+    FFT_PLAN_BLUESTEIN,     // any other length, chirp-z over a power-of-two convolution
+    FFT_PLAN_SPLIT          // real input as a half-length complex plan plus a split pass
+};
+
+// Everything needed to transform one length. Tables, scratch and nested
+// plans live in memory handed to FFT_Plan_Init, so the plan itself never
+// allocates. The scratch makes a plan single-threaded.
+struct FFT_Plan {
+    int length;
+    bool real;
+    FFT_Plan_Kind kind;
+    int complex_length;     // length for complex plans, length / 2 for split real plans
+    FFT_Plan* inner;        // half-length plan (split) or power-of-two convolution plan (Bluestein)
+    float* split;           // e^(-j*2*pi*k/N), k < N/2, split real plans only
+    // Mixed radix: factors in stage order, per-stage twiddles and a ping-pong buffer
+    int factor_count;
+    uint8_t factors[FFT_PLAN_MAX_FACTORS];
+    float* stage_twiddle;
+    float* scratch;
+    // Bluestein: chirp e^(-j*pi*n^2/N), the chirp filter's spectrum / M, and an M-point work buffer
+    float* chirp;
+    float* chirp_spectrum;
+    float* work;
+#if FFT_BACKEND_CMSIS
+    const arm_cfft_instance_f32* cfft;
+    arm_rfft_fast_instance_f32 rfft;
+#else
+    float* twiddle;         // per-stage twiddles, stage with half-size h starts at entry h - 1
+    uint16_t* bitrev;
+#endif
+};
+
+// Complex plans take any length >= 2, real plans any even length >= 4
+bool FFT_Plan_Supported(int length, bool real);
+// Bytes of table memory FFT_Plan_Init needs (0 for CMSIS-native lengths)
+size_t FFT_Plan_Size(int length, bool real);
+bool FFT_Plan_Init(FFT_Plan* plan, int length, bool real, void* memory);
+
+// In place over `length` interleaved complex values; the inverse scales by 1/N
+void FFT_Forward_Complex(const FFT_Plan* plan, float* data);
+void FFT_Inverse_Complex(const FFT_Plan* plan, float* data);
+// CMSIS packing: out[0] = X[0], out[1] = X[N/2], then X[k] for 0 < k < N/2.
+// Both directions clobber their input; the inverse scales by 1/N.
+void FFT_Forward_Real(const FFT_Plan* plan, float* in, float* out);
+void FFT_Inverse_Real(const FFT_Plan* plan, float* in, float* out);
+
+void FFT_Magnitude(const float* data, float* mag, int count);
+void FFT_Magnitude_Squared(const float* data, float* mag, int count);
+
+// In-place spectrum averaging: avg += alpha * (x - avg). The hold variants
+// keep the larger (smaller) of x and that decayed value, so alpha = 0 holds
+// forever and alpha sets the release rate otherwise.
+void FFT_Smooth(float* avg, const float* x, float alpha, int count);
+void FFT_Peak_Hold(float* avg, const float* x, float alpha, int count);
+void FFT_Min_Hold(float* avg, const float* x, float alpha, int count);
+
+#endif
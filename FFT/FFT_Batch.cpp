@@ -0,0 +1,62 @@
+#include "FFT_Batch.hpp"
+
+FFTBatch::FFTBatch(FFT *fft, int channels)
+    : fft(fft), channels(channels)
+{
+    if (channels < 1 || channels > FFT_BATCH_MAX_CHANNELS)
+    {
+        errno = EINVAL;
+        perror("Unsupported channel count");
+        exit(EXIT_FAILURE);
+    }
+    memset(peak_count, 0, sizeof(peak_count));
+}
+
+bool FFTBatch::FFT_BATCH_PROCESS(uint16_t *adc_buffer, FFT_Layout layout)
+{
+    // Both carry state from frame to frame, which would mix the channels
+    if (fft->getAveraging() != FFT_AVERAGE_NONE || fft->getTracking())
+    {
+        return false;
+    }
+
+    int length = fft->getLength();
+    for (int ch = 0; ch < channels; ch++)
+    {
+        if (layout == FFT_LAYOUT_INTERLEAVED)
+        {
+            fft->convert(adc_buffer + ch, channels);
+        }
+        else
+        {
+            fft->convert(adc_buffer + ch * length, 1);
+        }
+        fft->transform();
+        fft->magnitude();
+        fft->search();
+
+        peak_count[ch] = fft->getPeakCount();
+        memcpy(peaks[ch], fft->getPeaks(), peak_count[ch] * sizeof(FFT_Peak));
+    }
+    return true;
+}
+
+int FFTBatch::getChannels()
+{
+    return channels;
+}
+
+const FFT_Peak *FFTBatch::getPeaks(int channel)
+{
+    return peaks[channel];
+}
+
+int FFTBatch::getPeakCount(int channel)
+{
+    return peak_count[channel];
+}
+
+FFT *FFTBatch::getFFT()
+{
+    return fft;
+}
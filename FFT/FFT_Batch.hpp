@@ -0,0 +1,39 @@
+#ifndef __FFT_BATCH_H
+#define __FFT_BATCH_H
+
+#include "FFT.hpp"
+
+#define FFT_BATCH_MAX_CHANNELS 8
+
+enum FFT_Layout
+{
+    FFT_LAYOUT_PLANAR,          // channel 0 block, then channel 1 block, ...
+    FFT_LAYOUT_INTERLEAVED      // one sample per channel per scan step
+};
+
+// Runs several multiplexed channels (e.g. the CD4051 inputs) through one FFT.
+// The plan, twiddles, window and scratch buffers are the shared FFT's; each
+// channel only adds its peak list, so memory is flat in the channel count.
+// Channels are transformed one after another so the working set stays that
+// of a single transform. The FFT's sample rate must be the per-channel rate,
+// and averaging and tracking must be off: the averaged spectrum and the
+// peak tracker are per FFT, so they would blend one channel into the next.
+class FFTBatch
+{
+private:
+    FFT *fft;
+    int channels;
+    FFT_Peak peaks[FFT_BATCH_MAX_CHANNELS][FFT_MAX_PEAKS];
+    int peak_count[FFT_BATCH_MAX_CHANNELS];
+public:
+    FFTBatch(FFT *fft, int channels);
+    // adc_buffer holds channels * fft_length samples; false if the shared FFT
+    // is set up for averaging or tracking
+    bool FFT_BATCH_PROCESS(uint16_t *adc_buffer, FFT_Layout layout);
+    int getChannels();
+    const FFT_Peak *getPeaks(int channel);
+    int getPeakCount(int channel);
+    FFT *getFFT();
+};
+
+#endif // __FFT_BATCH_H
@@ -0,0 +1,251 @@
+#include "FFT_Bench.hpp"
+#include "SlidingDFT.hpp"
+
+#if !FFT_BACKEND_CMSIS
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define FFT_BENCH_TSC 1
+#else
+#include <chrono>
+#endif
+#endif
+
+#define FFT_BENCH_MAX_LENGTH 4096
+#define FFT_BENCH_CALIBRATION_RUNS 64
+
+FFTBench::FFTBench(float sample_rate) : sample_rate(sample_rate), frame_length(0)
+{
+    frame = (uint16_t *)malloc(FFT_BENCH_MAX_LENGTH * sizeof(uint16_t));
+    if (frame == NULL)
+    {
+        perror("Failed to allocate memory for benchmark frame");
+        exit(EXIT_FAILURE);
+    }
+    Init_Counter();
+    overhead = calibrate();
+}
+
+FFTBench::~FFTBench()
+{
+    free(frame);
+}
+
+void FFTBench::Init_Counter(void)
+{
+#if FFT_BACKEND_CMSIS
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+uint64_t FFTBench::Ticks(void)
+{
+#if FFT_BACKEND_CMSIS
+    return DWT->CYCCNT;
+#elif defined(FFT_BENCH_TSC)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+const char *FFTBench::Unit(void)
+{
+#if FFT_BACKEND_CMSIS || defined(FFT_BENCH_TSC)
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+
+// Differences wrap correctly for the 32-bit DWT counter
+static uint64_t elapsed(uint64_t start, uint64_t end)
+{
+#if FFT_BACKEND_CMSIS
+    return (uint32_t)((uint32_t)end - (uint32_t)start);
+#else
+    return end - start;
+#endif
+}
+
+// Smallest reading of an empty timed region; the minimum rejects interrupts
+// and preemption that land inside a run
+uint64_t FFTBench::calibrate(void)
+{
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < FFT_BENCH_CALIBRATION_RUNS; i++)
+    {
+        uint64_t t0 = Ticks();
+        uint64_t t1 = Ticks();
+        uint64_t ticks = elapsed(t0, t1);
+        best = ticks < best ? ticks : best;
+    }
+    return best;
+}
+
+// Ticks left after removing the counter overhead of `regions` timed regions
+uint64_t FFTBench::net(uint64_t ticks, uint64_t regions)
+{
+    uint64_t cost = overhead * regions;
+    return ticks > cost ? ticks - cost : 0;
+}
+
+uint64_t FFTBench::getOverhead(void)
+{
+    return overhead;
+}
+
+// Two tones plus LCG noise around mid-scale, so every stage sees real work
+void FFTBench::fill_frame(int length)
+{
+    uint32_t seed = 12345;
+    for (int i = 0; i < length; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        float t = (float)i / sample_rate;
+        float x = 2048.0f + 1200.0f * sinf(6.2831853f * (sample_rate / 8.3f) * t) +
+                  300.0f * sinf(6.2831853f * (sample_rate / 3.1f) * t) +
+                  (float)(seed >> 26) - 32.0f;
+        frame[i] = (uint16_t)x;
+    }
+    frame_length = length;
+}
+
+bool FFTBench::Run(int fft_length, FFT_Mode mode, int frames, FFT_Bench_Result *result)
+{
+    if (fft_length > FFT_BENCH_MAX_LENGTH || frames < 1 || !FFT::Is_Supported(fft_length, mode))
+    {
+        return false;
+    }
+    if (frame_length != fft_length)
+    {
+        fill_frame(fft_length);
+    }
+
+    FFT fft(fft_length, sample_rate, mode);
+    fft.setWindow(FFT_WINDOW_HANN);
+    fft.setDCRemoval(true);
+    // One untimed frame warms caches and branch predictors
+    fft.FFT_PROCESS(frame);
+
+    uint64_t stage[4] = {0, 0, 0, 0};
+    for (int f = 0; f < frames; f++)
+    {
+        uint64_t t0 = Ticks();
+        fft.convert(frame);
+        uint64_t t1 = Ticks();
+        fft.transform();
+        uint64_t t2 = Ticks();
+        fft.magnitude();
+        uint64_t t3 = Ticks();
+        fft.search();
+        uint64_t t4 = Ticks();
+        stage[0] += elapsed(t0, t1);
+        stage[1] += elapsed(t1, t2);
+        stage[2] += elapsed(t2, t3);
+        stage[3] += elapsed(t3, t4);
+    }
+
+    result->fft_length = fft_length;
+    result->mode = mode;
+    result->convert = (uint32_t)(net(stage[0], frames) / frames);
+    result->transform = (uint32_t)(net(stage[1], frames) / frames);
+    result->magnitude = (uint32_t)(net(stage[2], frames) / frames);
+    result->search = (uint32_t)(net(stage[3], frames) / frames);
+    result->total = result->convert + result->transform + result->magnitude + result->search;
+    return true;
+}
+
+bool FFTBench::Run_SlidingDFT(int fft_length, int bins, int frames, float *sdft_per_sample, float *fft_per_sample)
+{
+    FFT_Bench_Result block;
+    if (bins < 1 || bins > SDFT_MAX_BINS || !Run(fft_length, FFT_MODE_REAL, frames, &block))
+    {
+        return false;
+    }
+
+    SlidingDFT sdft(fft_length, sample_rate);
+    for (int i = 0; i < bins; i++)
+    {
+        sdft.addBin(1 + i * (fft_length / 2 - 1) / bins);
+    }
+
+    uint64_t start = Ticks();
+    for (int f = 0; f < frames; f++)
+    {
+        for (int i = 0; i < fft_length; i++)
+        {
+            sdft.SDFT_PUSH(frame[i]);
+        }
+    }
+    uint64_t total = net(elapsed(start, Ticks()), 1);
+
+    *sdft_per_sample = (float)total / ((float)frames * fft_length);
+    *fft_per_sample = (float)block.total / fft_length;
+    return true;
+}
+
+void FFTBench::Run_All(int frames, Output_t output)
+{
+    static const char *mode_names[] = {"complex", "real"};
+    static const char *stage_names[] = {"convert", "transform", "magnitude", "search", "total"};
+    char line[96];
+
+    // One measurement per row: per-frame stage costs, then per-sample SDFT vs FFT
+    // Powers of two, then mixed-radix frame sizes and a prime for Bluestein
+    static const int other_lengths[] = {1000, 2000, 3000, 1009};
+    int lengths[16];
+    int length_count = 0;
+    for (int length = 16; length <= FFT_BENCH_MAX_LENGTH; length <<= 1)
+    {
+        lengths[length_count++] = length;
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        lengths[length_count++] = other_lengths[i];
+    }
+
+    output("kind,mode,length,bins,unit,stage,value");
+    for (int mode = FFT_MODE_COMPLEX; mode <= FFT_MODE_REAL; mode++)
+    {
+        for (int l = 0; l < length_count; l++)
+        {
+            int length = lengths[l];
+            FFT_Bench_Result r;
+            if (!Run(length, (FFT_Mode)mode, frames, &r))
+            {
+                continue;
+            }
+            uint32_t values[] = {r.convert, r.transform, r.magnitude, r.search, r.total};
+            for (int i = 0; i < 5; i++)
+            {
+                snprintf(line, sizeof(line), "fft,%s,%d,0,%s,%s,%lu",
+                         mode_names[mode], length, Unit(), stage_names[i], (unsigned long)values[i]);
+                output(line);
+            }
+        }
+    }
+
+    for (int length = 64; length <= FFT_BENCH_MAX_LENGTH; length <<= 2)
+    {
+        for (int bins = 1; bins <= SDFT_MAX_BINS; bins <<= 2)
+        {
+            float sdft, block;
+            if (!Run_SlidingDFT(length, bins, frames, &sdft, &block))
+            {
+                continue;
+            }
+            // Fixed two decimals through integers, since target printf has no %f
+            unsigned long sdft_hundredths = (unsigned long)(sdft * 100.0f + 0.5f);
+            unsigned long block_hundredths = (unsigned long)(block * 100.0f + 0.5f);
+            snprintf(line, sizeof(line), "sdft,real,%d,%d,%s,per_sample,%lu.%02lu",
+                     length, bins, Unit(), sdft_hundredths / 100, sdft_hundredths % 100);
+            output(line);
+            snprintf(line, sizeof(line), "fft,real,%d,%d,%s,per_sample,%lu.%02lu",
+                     length, bins, Unit(), block_hundredths / 100, block_hundredths % 100);
+            output(line);
+        }
+    }
+}
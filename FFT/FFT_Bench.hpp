@@ -0,0 +1,51 @@
+#ifndef __FFT_BENCH_H
+#define __FFT_BENCH_H
+
+#include "FFT.hpp"
+#include <functional>
+
+// Per-frame cost of each FFT_PROCESS stage, averaged over the run, with the
+// cost of reading the counter itself taken out. Units are DWT cycles on
+// target, TSC cycles on x86 hosts and nanoseconds elsewhere.
+struct FFT_Bench_Result {
+    int fft_length;
+    FFT_Mode mode;
+    uint32_t convert;
+    uint32_t transform;
+    uint32_t magnitude;
+    uint32_t search;
+    uint32_t total;
+};
+
+// Benchmark harness for FFT and, for comparison, SlidingDFT. Results are
+// emitted as CSV lines through Output so they can go to a UART or stdout.
+class FFTBench {
+private:
+using Output_t = std::function<void(const char *)>;
+    float sample_rate;
+    uint16_t *frame;    // synthetic ADC frame, largest length
+    int frame_length;
+    uint64_t overhead;  // ticks an empty timed region reads
+
+    void fill_frame(int length);
+    uint64_t calibrate(void);
+    uint64_t net(uint64_t ticks, uint64_t regions);
+public:
+    FFTBench(float sample_rate);
+    ~FFTBench();
+
+    static void Init_Counter(void);
+    static uint64_t Ticks(void);
+    static const char *Unit(void);
+    uint64_t getOverhead(void);
+
+    bool Run(int fft_length, FFT_Mode mode, int frames, FFT_Bench_Result *result);
+    // Per-sample cost of tracking `bins` bins with SlidingDFT versus the block
+    // FFT amortised over a frame
+    bool Run_SlidingDFT(int fft_length, int bins, int frames, float *sdft_per_sample, float *fft_per_sample);
+    // Every power-of-2 length from 16 to 4096 plus 1000, 2000, 3000 and 1009,
+    // in both modes; unsupported combinations are skipped
+    void Run_All(int frames, Output_t output);
+};
+
+#endif
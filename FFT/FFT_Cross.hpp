@@ -0,0 +1,20 @@
+#ifndef __FFT_CROSS_H
+#define __FFT_CROSS_H
+
+#include "FFT_Peaks.hpp"
+
+struct FFT_CrossPeak {
+    float frequency;    // Hz, interpolated on |X * conj(Y)|
+    float magnitude;    // sqrt(|X| * |Y|), same units as getPeaks()
+    float phase;        // rad in (-pi, pi], channel A minus channel B
+    float delay;        // s, phase delay -phase / (2*pi*f): positive when A lags B, modulo one period
+};
+
+// Two-channel result of FFT_CROSS_PROCESS, peaks strongest first
+struct FFT_Cross {
+    int peak_count;
+    FFT_CrossPeak peaks[FFT_MAX_PEAKS];
+    float group_delay;  // s, -d(phase)/d(omega) fitted across the peaks, 0 with fewer than two
+};
+
+#endif
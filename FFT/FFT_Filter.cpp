@@ -0,0 +1,144 @@
+#include "FFT_Filter.hpp"
+
+FFTFilter::FFTFilter(FFT *fft, const float *taps, int tap_count)
+    : fft(fft), plan(fft->getPlan()), real(fft->getMode() == FFT_MODE_REAL),
+      fft_length(fft->getLength()), tap_capacity(tap_count)
+{
+    if (tap_count < 1 || tap_count >= fft_length)
+    {
+        errno = EINVAL;
+        perror("Unsupported FIR length");
+        exit(EXIT_FAILURE);
+    }
+    block_length = fft_length - tap_count + 1;
+
+    int values = real ? fft_length : 2 * fft_length;
+    frame = (float *)malloc(fft_length * sizeof(float));
+    work = real ? (float *)malloc(fft_length * sizeof(float)) : NULL;
+    spectrum = (float *)malloc(values * sizeof(float));
+    response = (float *)malloc(values * sizeof(float));
+    if (frame == NULL || (real && work == NULL) || spectrum == NULL || response == NULL)
+    {
+        perror("Failed to allocate memory for FFT filter");
+        exit(EXIT_FAILURE);
+    }
+    setTaps(taps, tap_count);
+    reset();
+}
+
+FFTFilter::~FFTFilter()
+{
+    free(frame);
+    free(work);
+    free(spectrum);
+    free(response);
+}
+
+bool FFTFilter::setTaps(const float *taps, int tap_count)
+{
+    if (tap_count < 1 || tap_count > tap_capacity)
+    {
+        return false;
+    }
+
+    // The inverse transforms already scale by 1/N, so H is used as is
+    if (real)
+    {
+        memset(work, 0, fft_length * sizeof(float));
+        memcpy(work, taps, tap_count * sizeof(float));
+        FFT_Forward_Real(plan, work, response);
+    }
+    else
+    {
+        memset(response, 0, 2 * fft_length * sizeof(float));
+        for (int i = 0; i < tap_count; i++)
+        {
+            response[2 * i] = taps[i];
+        }
+        FFT_Forward_Complex(plan, response);
+    }
+    return true;
+}
+
+void FFTFilter::reset()
+{
+    memset(frame, 0, fft_length * sizeof(float));
+}
+
+int FFTFilter::getBlockLength()
+{
+    return block_length;
+}
+
+int FFTFilter::getTapCapacity()
+{
+    return tap_capacity;
+}
+
+FFT *FFTFilter::getFFT()
+{
+    return fft;
+}
+
+void FFTFilter::FIR_PUSH(const float *samples, float *output)
+{
+    memcpy(frame + tap_capacity - 1, samples, block_length * sizeof(float));
+    filter_block(output);
+}
+
+void FFTFilter::FIR_PUSH(const uint16_t *samples, float *output)
+{
+    float *block = frame + tap_capacity - 1;
+    for (int i = 0; i < block_length; i++)
+    {
+        block[i] = (float)samples[i];
+    }
+    filter_block(output);
+}
+
+// Circular convolution of the frame with h; the first taps - 1 outputs wrap
+// around and are dropped, the rest are the linear convolution
+void FFTFilter::filter_block(float *output)
+{
+    int keep = tap_capacity - 1;
+    if (real)
+    {
+        memcpy(work, frame, fft_length * sizeof(float));
+        FFT_Forward_Real(plan, work, spectrum);
+
+        // Bins 0 and N/2 are purely real and packed into the first pair
+        spectrum[0] *= response[0];
+        spectrum[1] *= response[1];
+        for (int k = 1; k < fft_length / 2; k++)
+        {
+            float xr = spectrum[2 * k];
+            float xi = spectrum[2 * k + 1];
+            spectrum[2 * k] = xr * response[2 * k] - xi * response[2 * k + 1];
+            spectrum[2 * k + 1] = xr * response[2 * k + 1] + xi * response[2 * k];
+        }
+        FFT_Inverse_Real(plan, spectrum, work);
+        memmove(frame, frame + block_length, keep * sizeof(float));
+        memcpy(output, work + keep, block_length * sizeof(float));
+        return;
+    }
+
+    for (int i = 0; i < fft_length; i++)
+    {
+        spectrum[2 * i] = frame[i];
+        spectrum[2 * i + 1] = 0.0f;
+    }
+    FFT_Forward_Complex(plan, spectrum);
+    for (int k = 0; k < fft_length; k++)
+    {
+        float xr = spectrum[2 * k];
+        float xi = spectrum[2 * k + 1];
+        spectrum[2 * k] = xr * response[2 * k] - xi * response[2 * k + 1];
+        spectrum[2 * k + 1] = xr * response[2 * k + 1] + xi * response[2 * k];
+    }
+    FFT_Inverse_Complex(plan, spectrum);
+    memmove(frame, frame + block_length, keep * sizeof(float));
+    for (int i = 0; i < block_length; i++)
+    {
+        output[i] = spectrum[2 * (keep + i)];
+    }
+}
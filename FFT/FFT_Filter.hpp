@@ -0,0 +1,47 @@
+#ifndef __FFT_FILTER_H
+#define __FFT_FILTER_H
+
+#include "FFT.hpp"
+
+// Overlap-save fast convolution on the transform plan of an existing FFT.
+// Each block of getBlockLength() = N - taps + 1 new samples costs one
+// forward and one inverse N-point transform plus N/2 complex multiplies,
+// instead of taps multiplies per sample. N >= 2 * taps keeps the block
+// length at least half the transform. Real-mode FFTs use the real plan,
+// complex-mode ones transform with a zero imaginary part.
+// The FFT's own buffers are left alone, so filtered blocks can be handed
+// to FFT_PROCESS(const float*) in the same loop.
+class FFTFilter {
+private:
+    FFT *fft;
+    const FFT_Plan *plan;
+    bool real;
+    int fft_length;
+    int tap_capacity;
+    int block_length;
+    float *frame;       // last taps - 1 inputs followed by the new block
+    float *work;        // real mode only: transform input and output
+    float *spectrum;
+    float *response;    // filter spectrum, packed like the transform output
+
+    void filter_block(float *output);
+public:
+    // tap_count must be below the FFT length; false from setTaps leaves the
+    // previous response in place
+    FFTFilter(FFT *fft, const float *taps, int tap_count);
+    ~FFTFilter();
+
+    // At most the constructor's tap count; shorter filters are zero-padded
+    bool setTaps(const float *taps, int tap_count);
+    // Zeroes the overlap so the next block starts from silence
+    void reset();
+    int getBlockLength();
+    int getTapCapacity();
+    FFT *getFFT();
+
+    // Filters getBlockLength() samples into output; output may alias a float input
+    void FIR_PUSH(const float *samples, float *output);
+    void FIR_PUSH(const uint16_t *samples, float *output);
+};
+
+#endif
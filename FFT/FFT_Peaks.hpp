@@ -0,0 +1,150 @@
+#ifndef __FFT_PEAKS_H
+#define __FFT_PEAKS_H
+
+#include <stdint.h>
+#include <math.h>
+
+#define FFT_MAX_PEAKS 16
+
+enum FFT_Interp {
+    FFT_INTERP_NONE,
+    FFT_INTERP_PARABOLIC,   // parabola through the peak bin and its neighbours
+    FFT_INTERP_GAUSSIAN     // parabola through the log magnitudes, exact for Gaussian lobes
+};
+
+struct FFT_Peak {
+    float frequency;    // Hz, including the sub-bin offset
+    float magnitude;    // interpolated peak height
+    int bin;            // integer bin of the local maximum
+};
+
+// Single-pass top-K local maximum search over a magnitude spectrum
+class FFT_PeakFinder {
+public:
+    int max_peaks = 5;
+    int min_spacing = 2;    // local maxima closer than this many bins are one peak
+    FFT_Interp interp = FFT_INTERP_GAUSSIAN;
+
+    // Searches bins [first, last]; mag[first - 1] and mag[last + 1] must be readable.
+    // Peaks come back strongest first, frequency = base_hz + (bin + offset) * bin_hz.
+    template <typename T>
+    int Find(const T *mag, int first, int last, float bin_hz, float base_hz, FFT_Peak *peaks) const;
+
+    // Sub-bin offset in [-0.5, 0.5] and interpolated height for a peak at mag[1]
+    template <typename T>
+    float Interpolate(const T *mag, float *height) const;
+};
+
+template <typename T>
+int FFT_PeakFinder::Find(const T *mag, int first, int last, float bin_hz, float base_hz, FFT_Peak *peaks) const
+{
+    int limit = max_peaks < 1 ? 1 : (max_peaks > FFT_MAX_PEAKS ? FFT_MAX_PEAKS : max_peaks);
+    T heights[FFT_MAX_PEAKS];
+    int bins[FFT_MAX_PEAKS];
+    int count = 0;
+
+    for (int i = first; i <= last; i++)
+    {
+        T current = mag[i];
+        if (!(current > mag[i - 1] && current >= mag[i + 1]))
+        {
+            continue;
+        }
+        if (count == limit && !(current > heights[count - 1]))
+        {
+            continue;
+        }
+
+        // Bins are visited in order, so at most one kept peak can be too close
+        int slot = count;
+        for (int j = 0; j < count; j++)
+        {
+            if (i - bins[j] < min_spacing)
+            {
+                slot = j;
+                break;
+            }
+        }
+        if (slot < count)
+        {
+            if (!(current > heights[slot]))
+            {
+                continue;
+            }
+            for (int j = slot; j < count - 1; j++)
+            {
+                heights[j] = heights[j + 1];
+                bins[j] = bins[j + 1];
+            }
+            count--;
+        }
+        else if (count == limit)
+        {
+            count--;
+        }
+
+        int j = count;
+        while (j > 0 && current > heights[j - 1])
+        {
+            heights[j] = heights[j - 1];
+            bins[j] = bins[j - 1];
+            j--;
+        }
+        heights[j] = current;
+        bins[j] = i;
+        count++;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        float height;
+        float offset = Interpolate(mag + bins[i] - 1, &height);
+        peaks[i].frequency = base_hz + (bins[i] + offset) * bin_hz;
+        peaks[i].magnitude = height;
+        peaks[i].bin = bins[i];
+    }
+    return count;
+}
+
+template <typename T>
+float FFT_PeakFinder::Interpolate(const T *mag, float *height) const
+{
+    float a = (float)mag[0];
+    float b = (float)mag[1];
+    float c = (float)mag[2];
+    *height = b;
+
+    if (interp == FFT_INTERP_NONE)
+    {
+        return 0.0f;
+    }
+
+    bool gaussian = interp == FFT_INTERP_GAUSSIAN && a > 0.0f && b > 0.0f && c > 0.0f;
+    if (gaussian)
+    {
+        a = logf(a);
+        b = logf(b);
+        c = logf(c);
+    }
+
+    float denom = a - 2.0f * b + c;
+    if (denom >= 0.0f)
+    {
+        return 0.0f;
+    }
+    float offset = 0.5f * (a - c) / denom;
+    if (offset > 0.5f)
+    {
+        offset = 0.5f;
+    }
+    else if (offset < -0.5f)
+    {
+        offset = -0.5f;
+    }
+
+    float peak = b - 0.25f * (a - c) * offset;
+    *height = gaussian ? expf(peak) : peak;
+    return offset;
+}
+
+#endif
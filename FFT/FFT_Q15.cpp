@@ -0,0 +1,274 @@
+#include "FFT_Q15.hpp"
+
+FFTQ15::FFTQ15(int fft_length, float sample_rate)
+    : fft_length(fft_length), sample_rate(sample_rate), window_table(NULL),
+      window(FFT_WINDOW_NONE), block_exponent(0), peak_count(0)
+{
+    memset(main_Frequencies, 0, sizeof(main_Frequencies));
+
+    // The transform consumes its input, so the magnitudes can reuse it
+    fft_inputbuf = (q15_t *)malloc(fft_length * sizeof(q15_t));
+    fft_spectrum = (q15_t *)malloc(fft_length * 2 * sizeof(q15_t));
+    fft_outputbuf = fft_inputbuf;
+    if (fft_inputbuf == NULL || fft_spectrum == NULL)
+    {
+        perror("Failed to allocate memory for FFT buffers");
+        exit(EXIT_FAILURE);
+    }
+
+#if FFT_BACKEND_CMSIS
+    if (arm_rfft_init_q15(&srfft, fft_length, 0, 1) != ARM_MATH_SUCCESS)
+    {
+        errno = EINVAL;
+        perror("Unsupported FFT length");
+        exit(EXIT_FAILURE);
+    }
+#else
+    if (fft_length < 4 || (fft_length & (fft_length - 1)) != 0)
+    {
+        errno = EINVAL;
+        perror("Unsupported FFT length");
+        exit(EXIT_FAILURE);
+    }
+    twiddle = (q15_t *)malloc(fft_length * sizeof(q15_t));
+    if (twiddle == NULL)
+    {
+        perror("Failed to allocate memory for FFT twiddles");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < fft_length / 2; i++)
+    {
+        float x = 6.28318530717958647692f * i / fft_length;
+        twiddle[2 * i] = (q15_t)lrintf(fminf(cosf(x) * 32768.0f, 32767.0f));
+        twiddle[2 * i + 1] = (q15_t)lrintf(fminf(-sinf(x) * 32768.0f, 32767.0f));
+    }
+#endif
+}
+
+FFTQ15::~FFTQ15()
+{
+    free(fft_inputbuf);
+    free(fft_spectrum);
+    free(window_table);
+#if !FFT_BACKEND_CMSIS
+    free(twiddle);
+#endif
+}
+
+void FFTQ15::convert(uint16_t *adc_buffer)
+{
+    int32_t sum = 0;
+    int32_t lo = 0xFFFF;
+    int32_t hi = 0;
+    for (int i = 0; i < fft_length; i++)
+    {
+        int32_t x = adc_buffer[i];
+        sum += x;
+        lo = x < lo ? x : lo;
+        hi = x > hi ? x : hi;
+    }
+    int32_t mean = (sum + fft_length / 2) / fft_length;
+
+    // Largest shift that keeps the de-meaned frame inside q15
+    int32_t peak = hi - mean > mean - lo ? hi - mean : mean - lo;
+    int shift = 0;
+    while (shift < 15 && (peak << (shift + 1)) <= 32767)
+    {
+        shift++;
+    }
+    block_exponent = shift;
+
+    if (window == FFT_WINDOW_NONE)
+    {
+        for (int i = 0; i < fft_length; i++)
+        {
+            fft_inputbuf[i] = (q15_t)(((int32_t)adc_buffer[i] - mean) << shift);
+        }
+        return;
+    }
+
+    int half = fft_length / 2;
+    for (int i = 0; i <= half; i++)
+    {
+        int32_t x = ((int32_t)adc_buffer[i] - mean) << shift;
+        fft_inputbuf[i] = (q15_t)((x * window_table[i]) >> 15);
+    }
+    for (int i = half + 1; i < fft_length; i++)
+    {
+        int32_t x = ((int32_t)adc_buffer[i] - mean) << shift;
+        fft_inputbuf[i] = (q15_t)((x * window_table[fft_length - i]) >> 15);
+    }
+}
+
+void FFTQ15::transform()
+{
+#if FFT_BACKEND_CMSIS
+    arm_rfft_q15(&srfft, fft_inputbuf, fft_spectrum);
+#else
+    // Radix-2 DIT over the real samples, halving every stage so the result
+    // carries the same 1/N scaling as arm_rfft_q15
+    q15_t *x = fft_spectrum;
+    for (int i = 0, j = 0; i < fft_length; i++)
+    {
+        x[2 * j] = fft_inputbuf[i];
+        x[2 * j + 1] = 0;
+        int bit = fft_length >> 1;
+        while (j & bit)
+        {
+            j ^= bit;
+            bit >>= 1;
+        }
+        j |= bit;
+    }
+
+    for (int size = 2; size <= fft_length; size <<= 1)
+    {
+        int half = size >> 1;
+        int step = fft_length / size;
+        for (int start = 0; start < fft_length; start += size)
+        {
+            for (int k = 0; k < half; k++)
+            {
+                int32_t wr = twiddle[2 * k * step];
+                int32_t wi = twiddle[2 * k * step + 1];
+                q15_t *a = x + 2 * (start + k);
+                q15_t *b = a + 2 * half;
+                int32_t tr = (b[0] * wr - b[1] * wi) >> 15;
+                int32_t ti = (b[0] * wi + b[1] * wr) >> 15;
+                int32_t ar = a[0];
+                int32_t ai = a[1];
+                a[0] = (q15_t)((ar + tr) >> 1);
+                a[1] = (q15_t)((ai + ti) >> 1);
+                b[0] = (q15_t)((ar - tr) >> 1);
+                b[1] = (q15_t)((ai - ti) >> 1);
+            }
+        }
+    }
+#endif
+}
+
+void FFTQ15::magnitude()
+{
+#if FFT_BACKEND_CMSIS
+    arm_cmplx_mag_q15(fft_spectrum, fft_outputbuf, fft_length / 2 + 1);
+#else
+    // Same 2.14 output format as arm_cmplx_mag_q15
+    for (int i = 0; i <= fft_length / 2; i++)
+    {
+        int32_t re = fft_spectrum[2 * i];
+        int32_t im = fft_spectrum[2 * i + 1];
+        uint32_t power = (uint32_t)(re * re) + (uint32_t)(im * im);
+        uint32_t root = 0;
+        for (uint32_t bit = 1u << 30; bit != 0; bit >>= 2)
+        {
+            if (power >= root + bit)
+            {
+                power -= root + bit;
+                root = (root >> 1) + bit;
+            }
+            else
+            {
+                root >>= 1;
+            }
+        }
+        fft_outputbuf[i] = (q15_t)(root >> 1);
+    }
+#endif
+}
+
+bool FFTQ15::FFT_PROCESS(uint16_t *adc_buffer)
+{
+    convert(adc_buffer);
+    transform();
+    magnitude();
+
+    peak_count = peak_finder.Find(fft_outputbuf, 1, fft_length / 2 - 1,
+                                  sample_rate / fft_length, 0.0f, peaks);
+
+    // Undo the 1/N transform scaling, the 2.14 format and the block shift
+    float scale = 2.0f * fft_length / (float)(1 << block_exponent);
+    for (int i = 0; i < FFT_MAX_PEAKS; i++)
+    {
+        main_Frequencies[i] = i < peak_count ? peaks[i].frequency : 0.0f;
+        if (i < peak_count)
+        {
+            peaks[i].magnitude *= scale;
+        }
+    }
+    return true;
+}
+
+bool FFTQ15::setWindow(FFT_Window window)
+{
+    if (window != FFT_WINDOW_NONE && window_table == NULL)
+    {
+        window_table = (q15_t *)malloc((fft_length / 2 + 1) * sizeof(q15_t));
+        if (window_table == NULL)
+        {
+            return false;
+        }
+    }
+    if (window != FFT_WINDOW_NONE)
+    {
+        for (int i = 0; i <= fft_length / 2; i++)
+        {
+            float w = FFT_Window_Coefficient(window, i, fft_length);
+            window_table[i] = (q15_t)lrintf(fminf(w * 32768.0f, 32767.0f));
+        }
+    }
+    this->window = window;
+    return true;
+}
+
+void FFTQ15::setPeakCount(int count)
+{
+    if (count < 1)
+    {
+        count = 1;
+    }
+    else if (count > FFT_MAX_PEAKS)
+    {
+        count = FFT_MAX_PEAKS;
+    }
+    peak_finder.max_peaks = count;
+}
+
+void FFTQ15::setPeakSpacing(int bins)
+{
+    peak_finder.min_spacing = bins < 1 ? 1 : bins;
+}
+
+void FFTQ15::setInterpolation(FFT_Interp interp)
+{
+    peak_finder.interp = interp;
+}
+
+int FFTQ15::getLength()
+{
+    return fft_length;
+}
+
+float FFTQ15::getSampleRate()
+{
+    return sample_rate;
+}
+
+int FFTQ15::getBlockExponent()
+{
+    return block_exponent;
+}
+
+const float *FFTQ15::getMainFrequencies()
+{
+    return main_Frequencies;
+}
+
+const FFT_Peak *FFTQ15::getPeaks()
+{
+    return peaks;
+}
+
+int FFTQ15::getPeakCount()
+{
+    return peak_count;
+}
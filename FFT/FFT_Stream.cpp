@@ -0,0 +1,207 @@
+#include "FFT_Stream.hpp"
+#include <algorithm>
+
+#if FFT_BACKEND_CMSIS
+FFTStream::FFTStream(FFT *fft, ADC_HandleTypeDef *hadc, uint16_t *dma_buffer)
+    : fft(fft), adcHandle(hadc), dma_buffer(dma_buffer), frame_length(fft->getHopLength()),
+      ready_half(-1), busy_half(-1), busy_overrun(false), overrun_count(0), frame_count(0)
+{
+    init_frame();
+    if (adcHandle != nullptr)
+    {
+        InstancePool.push_back(this);
+    }
+}
+
+FFTStream::~FFTStream()
+{
+    InstancePool.erase(
+        std::remove(InstancePool.begin(), InstancePool.end(), this),
+        InstancePool.end());
+    free(frame);
+}
+
+HAL_StatusTypeDef FFTStream::Start(void)
+{
+    ready_half = -1;
+    busy_overrun = false;
+    frame_length = fft->getHopLength();
+    return HAL_ADC_Start_DMA(adcHandle, reinterpret_cast<uint32_t *>(dma_buffer), 2 * frame_length);
+}
+
+HAL_StatusTypeDef FFTStream::Stop(void)
+{
+    return HAL_ADC_Stop_DMA(adcHandle);
+}
+
+uint32_t FFTStream::enter_critical(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+
+void FFTStream::exit_critical(uint32_t state)
+{
+    __set_PRIMASK(state);
+}
+#else
+FFTStream::FFTStream(FFT *fft, uint16_t *dma_buffer)
+    : fft(fft), dma_buffer(dma_buffer), frame_length(fft->getHopLength()),
+      ready_half(-1), busy_half(-1), busy_overrun(false), overrun_count(0), frame_count(0)
+{
+    init_frame();
+}
+
+FFTStream::~FFTStream()
+{
+    free(frame);
+}
+
+void FFTStream::Start(void)
+{
+    ready_half = -1;
+    busy_overrun = false;
+    frame_length = fft->getHopLength();
+}
+
+uint32_t FFTStream::enter_critical(void)
+{
+    lock.lock();
+    return 0;
+}
+
+void FFTStream::exit_critical(uint32_t)
+{
+    lock.unlock();
+}
+#endif
+
+// Sized for the longest hop, so Start() can follow a later setOverlap()
+void FFTStream::init_frame(void)
+{
+    frame = (uint16_t *)malloc(fft->getLength() * sizeof(uint16_t));
+    if (frame == nullptr)
+    {
+        errno = ENOMEM;
+        perror("Failed to allocate memory for FFTStream frame");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void FFTStream::half_filled(int8_t half)
+{
+#if !FFT_BACKEND_CMSIS
+    std::lock_guard<std::mutex> guard(lock);
+#endif
+    // The DMA has just started writing the other half
+    int8_t other = half ^ 1;
+    if (ready_half == other)
+    {
+        overrun_count++;
+    }
+    if (busy_half == other)
+    {
+        busy_overrun = true;
+        overrun_count++;
+    }
+    ready_half = half;
+}
+
+void FFTStream::HalfComplete(void)
+{
+    half_filled(0);
+}
+
+void FFTStream::Complete(void)
+{
+    half_filled(1);
+}
+
+bool FFTStream::Poll(void)
+{
+    uint32_t state = enter_critical();
+    int8_t half = ready_half;
+    ready_half = -1;
+    busy_half = half;
+    busy_overrun = false;
+    exit_critical(state);
+
+    if (half < 0)
+    {
+        return false;
+    }
+
+    memcpy(frame, dma_buffer + half * frame_length, frame_length * sizeof(uint16_t));
+
+    state = enter_critical();
+    busy_half = -1;
+    bool corrupted = busy_overrun;
+    exit_critical(state);
+
+    // The DMA wrapped onto the half while it was being copied
+    if (corrupted)
+    {
+        return false;
+    }
+
+    bool updated = fft->FFT_PUSH(frame);
+    frame_count++;
+    if (!updated)
+    {
+        return false;
+    }
+    if (ReadyCallback)  ReadyCallback(*fft);
+    return true;
+}
+
+uint32_t FFTStream::getOverrunCount()
+{
+    return overrun_count;
+}
+
+uint32_t FFTStream::getFrameCount()
+{
+    return frame_count;
+}
+
+#if FFT_BACKEND_CMSIS
+ADC_HandleTypeDef *FFTStream::getAdcHandle()
+{
+    return adcHandle;
+}
+
+std::vector<FFTStream *> FFTStream::InstancePool;
+
+std::vector<FFTStream *> FFTStream::getInstancePool()
+{
+    return FFTStream::InstancePool;
+}
+
+const std::vector<FFTStream *> &FFTStream::getInstances()
+{
+    return FFTStream::InstancePool;
+}
+
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    for (FFTStream *instance : FFTStream::getInstances())
+    {
+        if (hadc->Instance == instance->getAdcHandle()->Instance)
+        {
+            instance->HalfComplete();
+        }
+    }
+}
+
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    for (FFTStream *instance : FFTStream::getInstances())
+    {
+        if (hadc->Instance == instance->getAdcHandle()->Instance)
+        {
+            instance->Complete();
+        }
+    }
+}
+#endif
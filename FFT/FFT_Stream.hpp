@@ -0,0 +1,69 @@
+#ifndef __FFT_STREAM_H
+#define __FFT_STREAM_H
+
+#include "FFT.hpp"
+#include <vector>
+#include <functional>
+#if !FFT_BACKEND_CMSIS
+#include <mutex>
+#endif
+
+// Continuous analysis from a circular ADC DMA buffer split into two halves.
+// The DMA callbacks only mark a half as ready; Poll() transforms it from the
+// main loop while the DMA keeps filling the other half. Each half holds one
+// hop of the FFT, so overlapped framing works unchanged. Host builds have no
+// ADC; a simulated producer fills the buffer and calls HalfComplete/Complete.
+// Poll() copies the half out before transforming it, so a half the DMA wraps
+// onto mid-read is dropped without reaching the overlap history.
+class FFTStream
+{
+private:
+using FrameCallback_t = std::function<void(FFT &)>;
+    FFT *fft;
+#if FFT_BACKEND_CMSIS
+    ADC_HandleTypeDef *adcHandle;
+#else
+    std::mutex lock;
+#endif
+    uint16_t *dma_buffer;     // 2 * getHopLength() samples
+    uint16_t *frame;          // private copy of the half being processed
+    int frame_length;         // samples per half, the FFT hop length
+    volatile int8_t ready_half;
+    volatile int8_t busy_half;
+    volatile bool busy_overrun;
+    volatile uint32_t overrun_count;
+    volatile uint32_t frame_count;
+    void half_filled(int8_t half);
+    void init_frame(void);
+    uint32_t enter_critical(void);
+    void exit_critical(uint32_t state);
+#if FFT_BACKEND_CMSIS
+    static std::vector<FFTStream *> InstancePool;
+public:
+    FFTStream(FFT *fft, ADC_HandleTypeDef *hadc, uint16_t *dma_buffer);
+    ~FFTStream();
+    HAL_StatusTypeDef Start(void);
+    HAL_StatusTypeDef Stop(void);
+#else
+public:
+    FFTStream(FFT *fft, uint16_t *dma_buffer);
+    ~FFTStream();
+    void Start(void);
+#endif
+    // Processes the pending half if there is one; true when new peaks are ready
+    bool Poll(void);
+    // Called from the DMA half-complete / complete interrupts (or a simulated producer)
+    void HalfComplete(void);
+    void Complete(void);
+    FrameCallback_t ReadyCallback = nullptr;
+    uint32_t getOverrunCount();
+    uint32_t getFrameCount();
+#if FFT_BACKEND_CMSIS
+    ADC_HandleTypeDef *getAdcHandle();
+    static std::vector<FFTStream *> getInstancePool();
+    // Allocation-free view of the pool for the DMA interrupts
+    static const std::vector<FFTStream *> &getInstances();
+#endif
+};
+
+#endif // __FFT_STREAM_H
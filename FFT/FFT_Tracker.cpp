@@ -0,0 +1,149 @@
+#include "FFT_Tracker.hpp"
+
+FFT_PeakTracker::FFT_PeakTracker()
+{
+    Reset();
+}
+
+void FFT_PeakTracker::Reset()
+{
+    track_count = 0;
+    next_id = 0;
+    frames_since_scan = 0;
+}
+
+void FFT_PeakTracker::smooth(FFT_Track *track, float frequency)
+{
+    track->frequency += smoothing * (frequency - track->frequency);
+    track->age++;
+}
+
+// Finds every peak afresh and hands each one the id of the nearest
+// unclaimed track, strongest peaks choosing first
+void FFT_PeakTracker::full_scan(const float *mag, int first, int last, float bin_hz, float base_hz, const FFT_PeakFinder &finder)
+{
+    FFT_Peak found[FFT_MAX_PEAKS];
+    FFT_Track next[FFT_MAX_PEAKS];
+    bool claimed[FFT_MAX_PEAKS] = {false};
+    int count = finder.Find(mag, first, last, bin_hz, base_hz, found);
+
+    for (int i = 0; i < count; i++)
+    {
+        int match = -1;
+        int distance = neighbourhood + 1;
+        for (int j = 0; j < track_count; j++)
+        {
+            int d = abs(found[i].bin - tracks[j].bin);
+            if (!claimed[j] && d < distance)
+            {
+                match = j;
+                distance = d;
+            }
+        }
+
+        if (match >= 0)
+        {
+            claimed[match] = true;
+            next[i] = tracks[match];
+            smooth(&next[i], found[i].frequency);
+        }
+        else
+        {
+            next[i].id = next_id++;
+            next[i].frequency = found[i].frequency;
+            next[i].age = 0;
+        }
+        next[i].magnitude = found[i].magnitude;
+        next[i].bin = found[i].bin;
+    }
+
+    memcpy(tracks, next, count * sizeof(FFT_Track));
+    track_count = count;
+}
+
+// Re-locates each track within its neighbourhood; false if any has collapsed
+bool FFT_PeakTracker::follow(const float *mag, int first, int last, float bin_hz, float base_hz, const FFT_PeakFinder &finder)
+{
+    FFT_Track next[FFT_MAX_PEAKS];
+    int count = 0;
+
+    for (int j = 0; j < track_count; j++)
+    {
+        int lo = tracks[j].bin - neighbourhood > first ? tracks[j].bin - neighbourhood : first;
+        int hi = tracks[j].bin + neighbourhood < last ? tracks[j].bin + neighbourhood : last;
+        int best = -1;
+        for (int i = lo; i <= hi; i++)
+        {
+            if (mag[i] > mag[i - 1] && mag[i] >= mag[i + 1] && (best < 0 || mag[i] > mag[best]))
+            {
+                best = i;
+            }
+        }
+        if (best < 0 || mag[best] < collapse_ratio * tracks[j].magnitude)
+        {
+            return false;
+        }
+
+        // Two tracks drifting onto one peak merge into the stronger one
+        bool merged = false;
+        for (int k = 0; k < count; k++)
+        {
+            if (abs(next[k].bin - best) < finder.min_spacing)
+            {
+                merged = true;
+                break;
+            }
+        }
+        if (merged)
+        {
+            continue;
+        }
+
+        float height;
+        float offset = finder.Interpolate(mag + best - 1, &height);
+        next[count] = tracks[j];
+        smooth(&next[count], base_hz + (best + offset) * bin_hz);
+        next[count].magnitude = height;
+        next[count].bin = best;
+        count++;
+    }
+
+    // Strongest first, as from a full scan
+    for (int i = 1; i < count; i++)
+    {
+        FFT_Track t = next[i];
+        int k = i;
+        while (k > 0 && t.magnitude > next[k - 1].magnitude)
+        {
+            next[k] = next[k - 1];
+            k--;
+        }
+        next[k] = t;
+    }
+
+    memcpy(tracks, next, count * sizeof(FFT_Track));
+    track_count = count;
+    return true;
+}
+
+int FFT_PeakTracker::Update(const float *mag, int first, int last, float bin_hz, float base_hz, const FFT_PeakFinder &finder)
+{
+    frames_since_scan++;
+    if (track_count == 0 || frames_since_scan >= rescan_interval ||
+        !follow(mag, first, last, bin_hz, base_hz, finder))
+    {
+        full_scan(mag, first, last, bin_hz, base_hz, finder);
+        frames_since_scan = 0;
+    }
+    return track_count;
+}
+
+const FFT_Track *FFT_PeakTracker::getTracks()
+{
+    return tracks;
+}
+
+int FFT_PeakTracker::getTrackCount()
+{
+    return track_count;
+}
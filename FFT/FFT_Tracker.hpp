@@ -0,0 +1,45 @@
+#ifndef __FFT_TRACKER_H
+#define __FFT_TRACKER_H
+
+#include "FFT_Peaks.hpp"
+#include <stdlib.h>
+#include <string.h>
+
+struct FFT_Track {
+    int id;             // stable for as long as the peak is followed
+    float frequency;    // Hz, exponentially smoothed across frames
+    float magnitude;    // this frame's interpolated height
+    int bin;
+    int age;            // frames since the track was started
+};
+
+// Follows peaks from frame to frame. Between full scans each track only
+// searches a few bins around where it was last seen; a full scan runs every
+// rescan_interval frames, or at once when a tracked peak vanishes or loses
+// most of its height.
+class FFT_PeakTracker {
+private:
+    FFT_Track tracks[FFT_MAX_PEAKS];
+    int track_count;
+    int next_id;
+    int frames_since_scan;
+
+    void full_scan(const float *mag, int first, int last, float bin_hz, float base_hz, const FFT_PeakFinder &finder);
+    bool follow(const float *mag, int first, int last, float bin_hz, float base_hz, const FFT_PeakFinder &finder);
+    void smooth(FFT_Track *track, float frequency);
+public:
+    int neighbourhood = 3;          // bins searched either side of a track
+    int rescan_interval = 16;       // frames between full scans
+    float collapse_ratio = 0.25f;   // rescan when a track falls below this share of its last height
+    float smoothing = 0.5f;         // weight of the newest frequency estimate
+
+    FFT_PeakTracker();
+    void Reset();
+    // Same contract as FFT_PeakFinder::Find; returns the number of tracks,
+    // strongest first
+    int Update(const float *mag, int first, int last, float bin_hz, float base_hz, const FFT_PeakFinder &finder);
+    const FFT_Track *getTracks();
+    int getTrackCount();
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef __FFT_WINDOW_H
+#define __FFT_WINDOW_H
+
+#include <math.h>
+
+enum FFT_Window {
+    FFT_WINDOW_NONE,
+    FFT_WINDOW_HANN,
+    FFT_WINDOW_HAMMING,
+    FFT_WINDOW_BLACKMAN_HARRIS,     // 4-term, -92 dB sidelobes
+    FFT_WINDOW_FLATTOP              // amplitude-accurate, wide main lobe
+};
+
+// Cosine-sum coefficients a0..a4 of each window,
+// w[i] = a0 - a1*cos(x) + a2*cos(2x) - a3*cos(3x) + a4*cos(4x), x = 2*pi*i/N
+constexpr float FFT_WINDOW_COEFFICIENTS[][5] = {
+    {1.0f, 0.0f, 0.0f, 0.0f, 0.0f},
+    {0.5f, 0.5f, 0.0f, 0.0f, 0.0f},
+    {0.54f, 0.46f, 0.0f, 0.0f, 0.0f},
+    {0.35875f, 0.48829f, 0.14128f, 0.01168f, 0.0f},
+    {0.21557895f, 0.41663158f, 0.277263158f, 0.083578947f, 0.006947368f},
+};
+
+// Half-width in bins of each window's main lobe, used to sum a tone's power
+constexpr int FFT_WINDOW_LOBE_BINS[] = {1, 2, 2, 4, 5};
+
+// Coefficient i of the periodic cosine-sum window of the given length
+inline float FFT_Window_Coefficient(FFT_Window window, int i, int length)
+{
+    const float *a = FFT_WINDOW_COEFFICIENTS[window];
+    float x = 6.28318530717958647692f * i / length;
+    return a[0] - a[1] * cosf(x) + a[2] * cosf(2.0f * x) -
+           a[3] * cosf(3.0f * x) + a[4] * cosf(4.0f * x);
+}
+
+#endif
@@ -0,0 +1,146 @@
+#include "Goertzel.hpp"
+
+#define GOERTZEL_TWO_PI 6.28318530717958647692f
+
+GoertzelBank::GoertzelBank(int block_length, float sample_rate)
+    : block_length(block_length), sample_rate(sample_rate), tone_count(0),
+      sample_index(0), dc_removal(false), dc_offset(0.0f), dc_sum(0)
+{
+}
+
+bool GoertzelBank::addTone(float frequency)
+{
+    if (tone_count == GOERTZEL_MAX_TONES)
+    {
+        return false;
+    }
+
+    int k = tone_count++;
+    omega[k] = GOERTZEL_TWO_PI * frequency / sample_rate;
+    coeff[k] = 2.0f * cosf(omega[k]);
+    results[k].frequency = frequency;
+    results[k].magnitude = 0.0f;
+    results[k].phase = 0.0f;
+    reset_state();
+    return true;
+}
+
+void GoertzelBank::clearTones()
+{
+    tone_count = 0;
+    reset_state();
+}
+
+void GoertzelBank::reset_state()
+{
+    for (int k = 0; k < tone_count; k++)
+    {
+        s1[k] = 0.0f;
+        s2[k] = 0.0f;
+    }
+    sample_index = 0;
+    dc_sum = 0;
+}
+
+// Generalised Goertzel: X = e^(-jw(N-1)) * (s[N-1] - e^(-jw) * s[N-2]),
+// valid for any w, not only integer bins
+void GoertzelBank::finish()
+{
+    for (int k = 0; k < tone_count; k++)
+    {
+        float re = s1[k] - cosf(omega[k]) * s2[k];
+        float im = sinf(omega[k]) * s2[k];
+        results[k].magnitude = sqrtf(re * re + im * im);
+        float phase = atan2f(im, re) - omega[k] * (block_length - 1);
+        results[k].phase = remainderf(phase, GOERTZEL_TWO_PI);
+        s1[k] = 0.0f;
+        s2[k] = 0.0f;
+    }
+}
+
+void GoertzelBank::GOERTZEL_PROCESS(uint16_t *adc_buffer)
+{
+    float offset = 0.0f;
+    if (dc_removal)
+    {
+        uint32_t sum = 0;
+        for (int i = 0; i < block_length; i++)
+        {
+            sum += adc_buffer[i];
+        }
+        offset = (float)sum / block_length;
+    }
+
+    // Tone-major order keeps both state words in registers
+    for (int k = 0; k < tone_count; k++)
+    {
+        float c = coeff[k];
+        float a = 0.0f;
+        float b = 0.0f;
+        for (int i = 0; i < block_length; i++)
+        {
+            float s = ((float)adc_buffer[i] - offset) + c * a - b;
+            b = a;
+            a = s;
+        }
+        s1[k] = a;
+        s2[k] = b;
+    }
+    finish();
+    sample_index = 0;
+}
+
+bool GoertzelBank::GOERTZEL_PUSH(uint16_t sample)
+{
+    float x = (float)sample - dc_offset;
+    for (int k = 0; k < tone_count; k++)
+    {
+        float s = x + coeff[k] * s1[k] - s2[k];
+        s2[k] = s1[k];
+        s1[k] = s;
+    }
+    dc_sum += sample;
+
+    if (++sample_index < block_length)
+    {
+        return false;
+    }
+
+    finish();
+    sample_index = 0;
+    if (dc_removal)
+    {
+        dc_offset = (float)dc_sum / block_length;
+    }
+    dc_sum = 0;
+    return true;
+}
+
+void GoertzelBank::setDCRemoval(bool enable)
+{
+    dc_removal = enable;
+    if (!enable)
+    {
+        dc_offset = 0.0f;
+    }
+}
+
+const Goertzel_Result *GoertzelBank::getResults()
+{
+    return results;
+}
+
+int GoertzelBank::getToneCount()
+{
+    return tone_count;
+}
+
+int GoertzelBank::getBlockLength()
+{
+    return block_length;
+}
+
+float GoertzelBank::getSampleRate()
+{
+    return sample_rate;
+}
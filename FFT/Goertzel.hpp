@@ -0,0 +1,52 @@
+#ifndef __GOERTZEL_H
+#define __GOERTZEL_H
+
+#include "stdint.h"
+#include "math.h"
+
+#define GOERTZEL_MAX_TONES 16
+
+struct Goertzel_Result {
+    float frequency;    // Hz, as requested
+    float magnitude;    // |X(f)|, same scale as an FFT bin magnitude
+    float phase;        // radians, relative to the first sample of the block
+};
+
+// Bank of generalised Goertzel filters for a few known, not necessarily
+// bin-centred, frequencies. Costs O(N*K) per block instead of a full FFT.
+class GoertzelBank {
+private:
+    int block_length;
+    float sample_rate;
+    int tone_count;
+    float omega[GOERTZEL_MAX_TONES];
+    float coeff[GOERTZEL_MAX_TONES];
+    float s1[GOERTZEL_MAX_TONES];
+    float s2[GOERTZEL_MAX_TONES];
+    Goertzel_Result results[GOERTZEL_MAX_TONES];
+    int sample_index;
+    bool dc_removal;
+    float dc_offset;
+    uint32_t dc_sum;
+
+    void reset_state();
+    void finish();
+public:
+    GoertzelBank(int block_length, float sample_rate);
+
+    bool addTone(float frequency);
+    void clearTones();
+    // Whole block at once: block_length samples
+    void GOERTZEL_PROCESS(uint16_t* adc_buffer);
+    // One sample as it arrives; true when a block has just completed
+    bool GOERTZEL_PUSH(uint16_t sample);
+    // Subtract the block mean; streaming mode uses the previous block's mean
+    void setDCRemoval(bool enable);
+
+    const Goertzel_Result* getResults();
+    int getToneCount();
+    int getBlockLength();
+    float getSampleRate();
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include "SlidingDFT.hpp"
+#include "string.h"
+
+#define SDFT_TWO_PI 6.28318530717958647692f
+
+SlidingDFT::SlidingDFT(int fft_length, float sample_rate, float damping)
+    : fft_length(fft_length), sample_rate(sample_rate), damping(damping), bin_count(0)
+{
+    history = (uint16_t *)malloc(fft_length * sizeof(uint16_t));
+    if (history == NULL)
+    {
+        perror("Failed to allocate memory for sliding DFT history");
+        exit(EXIT_FAILURE);
+    }
+    damping_n = powf(damping, (float)fft_length);
+    damping_gain = damping < 1.0f ? fft_length * (1.0f - damping) / (1.0f - damping_n) : 1.0f;
+    reset();
+}
+
+SlidingDFT::~SlidingDFT()
+{
+    free(history);
+}
+
+bool SlidingDFT::addBin(int bin)
+{
+    if (bin_count == SDFT_MAX_BINS || bin < 0 || bin > fft_length / 2)
+    {
+        return false;
+    }
+
+    int i = bin_count++;
+    float w = SDFT_TWO_PI * bin / fft_length;
+    bins[i] = bin;
+    twiddle_re[i] = damping * cosf(w);
+    twiddle_im[i] = damping * sinf(w);
+    state_re[i] = 0.0f;
+    state_im[i] = 0.0f;
+    return true;
+}
+
+bool SlidingDFT::addFrequency(float frequency)
+{
+    return addBin((int)lrintf(frequency * fft_length / sample_rate));
+}
+
+void SlidingDFT::clearBins()
+{
+    bin_count = 0;
+}
+
+void SlidingDFT::reset()
+{
+    memset(history, 0, fft_length * sizeof(uint16_t));
+    history_pos = 0;
+    for (int i = 0; i < bin_count; i++)
+    {
+        state_re[i] = 0.0f;
+        state_im[i] = 0.0f;
+    }
+}
+
+void SlidingDFT::SDFT_PUSH(uint16_t sample)
+{
+    float delta = (float)sample - damping_n * (float)history[history_pos];
+    history[history_pos] = sample;
+    if (++history_pos == fft_length)
+    {
+        history_pos = 0;
+    }
+
+    for (int i = 0; i < bin_count; i++)
+    {
+        float re = state_re[i];
+        float im = state_im[i];
+        state_re[i] = twiddle_re[i] * re - twiddle_im[i] * im + delta;
+        state_im[i] = twiddle_re[i] * im + twiddle_im[i] * re;
+    }
+}
+
+int SlidingDFT::getBinCount()
+{
+    return bin_count;
+}
+
+int SlidingDFT::getBin(int index)
+{
+    return bins[index];
+}
+
+float SlidingDFT::getFrequency(int index)
+{
+    return bins[index] * sample_rate / fft_length;
+}
+
+float SlidingDFT::getMagnitude(int index)
+{
+    return damping_gain * sqrtf(state_re[index] * state_re[index] + state_im[index] * state_im[index]);
+}
+
+float SlidingDFT::getPhase(int index)
+{
+    return atan2f(state_im[index], state_re[index]);
+}
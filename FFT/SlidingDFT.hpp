@@ -0,0 +1,55 @@
+#ifndef __SLIDING_DFT_H
+#define __SLIDING_DFT_H
+
+#include "stdint.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "errno.h"
+#include "math.h"
+
+#define SDFT_MAX_BINS 16
+
+// Damped sliding DFT: every new sample updates the selected bins of an
+// fft_length-point DFT in O(1) each, so a change is visible one sample later
+// instead of one frame later.
+//   S_k(n) = r * e^(j2pi*k/N) * S_k(n-1) + x(n) - r^N * x(n-N)
+// r slightly below 1 keeps rounding errors from accumulating forever. It also
+// weights older samples down, so a bin-centred tone reads low by
+// (1 - r^N) / (N * (1 - r)), about 5% at N=1024 and 18% at N=4096 with the
+// default r; getMagnitude() divides that gain back out.
+class SlidingDFT {
+private:
+    int fft_length;
+    float sample_rate;
+    float damping;
+    float damping_n;        // r^N, weight of the sample leaving the window
+    float damping_gain;     // 1 / ((1 - r^N) / (N * (1 - r))), 1 when undamped
+    uint16_t* history;      // last fft_length samples, circular
+    int history_pos;
+    int bin_count;
+    int bins[SDFT_MAX_BINS];
+    float twiddle_re[SDFT_MAX_BINS];    // r * e^(j2pi*k/N)
+    float twiddle_im[SDFT_MAX_BINS];
+    float state_re[SDFT_MAX_BINS];
+    float state_im[SDFT_MAX_BINS];
+public:
+    SlidingDFT(int fft_length, float sample_rate, float damping = 0.9999f);
+    ~SlidingDFT();
+
+    bool addBin(int bin);
+    // Tracks the bin nearest to the given frequency
+    bool addFrequency(float frequency);
+    void clearBins();
+    // Zeroes the window and every bin state
+    void reset();
+
+    void SDFT_PUSH(uint16_t sample);
+
+    int getBinCount();
+    int getBin(int index);
+    float getFrequency(int index);
+    float getMagnitude(int index);
+    float getPhase(int index);
+};
+
+#endif
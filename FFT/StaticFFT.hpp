@@ -0,0 +1,250 @@
+#ifndef __STATIC_FFT_H
+#define __STATIC_FFT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include "FFT_Peaks.hpp"
+#include "FFT_Window.hpp"
+
+// Real-input FFT analyzer specialised for a fixed length. Twiddles,
+// bit-reversal pairs and the window are constexpr tables in flash, all
+// buffers are members, so construction cannot fail and the RAM footprint
+// is sizeof(StaticFFT<N>).
+template <size_t N, FFT_Window W = FFT_WINDOW_NONE>
+class StaticFFT {
+    static_assert(N >= 16 && N <= 4096 && (N & (N - 1)) == 0,
+                  "StaticFFT length must be a power of 2 between 16 and 4096");
+
+private:
+    static constexpr size_t HALF = N / 2;
+
+    struct Tables {
+        float twiddle[N];               // e^(-j*2*pi*k/N), k < N/2, interleaved
+        uint16_t swap[HALF][2];         // bit-reversal pairs for the N/2-point CFFT
+        size_t swap_count;
+        float window[HALF + 1];         // first half of the symmetric window
+    };
+
+    static constexpr double PI_D = 3.14159265358979323846;
+
+    // Taylor series after reduction to [-pi, pi], good to double precision
+    static constexpr double cos_d(double x)
+    {
+        while (x > PI_D)
+        {
+            x -= 2.0 * PI_D;
+        }
+        while (x < -PI_D)
+        {
+            x += 2.0 * PI_D;
+        }
+        double term = 1.0;
+        double sum = 1.0;
+        for (int n = 1; n < 30; n++)
+        {
+            term *= -x * x / ((2 * n - 1) * (2 * n));
+            sum += term;
+        }
+        return sum;
+    }
+
+    static constexpr double sin_d(double x)
+    {
+        return cos_d(x - PI_D / 2.0);
+    }
+
+    static constexpr Tables make_tables()
+    {
+        Tables t = {};
+        for (size_t k = 0; k < HALF; k++)
+        {
+            t.twiddle[2 * k] = (float)cos_d(2.0 * PI_D * k / N);
+            t.twiddle[2 * k + 1] = (float)-sin_d(2.0 * PI_D * k / N);
+        }
+
+        t.swap_count = 0;
+        for (size_t i = 0, j = 0; i < HALF; i++)
+        {
+            if (i < j)
+            {
+                t.swap[t.swap_count][0] = (uint16_t)i;
+                t.swap[t.swap_count][1] = (uint16_t)j;
+                t.swap_count++;
+            }
+            size_t bit = HALF >> 1;
+            while (j & bit)
+            {
+                j ^= bit;
+                bit >>= 1;
+            }
+            j |= bit;
+        }
+
+        const float *a = FFT_WINDOW_COEFFICIENTS[W];
+        for (size_t i = 0; i <= HALF; i++)
+        {
+            double x = 2.0 * PI_D * i / N;
+            t.window[i] = (float)(a[0] - a[1] * cos_d(x) + a[2] * cos_d(2.0 * x) -
+                                  a[3] * cos_d(3.0 * x) + a[4] * cos_d(4.0 * x));
+        }
+        return t;
+    }
+
+    static constexpr Tables tables = make_tables();
+
+    float sample_rate;
+    bool dc_removal;
+    float fft_inputbuf[N];          // N real samples, transformed in place as N/2 complex
+    float fft_outputbuf[HALF + 1];
+    float main_Frequencies[FFT_MAX_PEAKS];
+    FFT_Peak peaks[FFT_MAX_PEAKS];
+    int peak_count;
+    FFT_PeakFinder peak_finder;
+
+    void convert(const uint16_t *adc_buffer);
+    void transform();
+    void magnitude();
+
+public:
+    explicit StaticFFT(float sample_rate)
+        : sample_rate(sample_rate), dc_removal(false), main_Frequencies(), peak_count(0)
+    {
+    }
+
+    bool FFT_PROCESS(const uint16_t *adc_buffer);
+
+    void setDCRemoval(bool enable) { dc_removal = enable; }
+    void setPeakCount(int count) { peak_finder.max_peaks = count < 1 ? 1 : (count > FFT_MAX_PEAKS ? FFT_MAX_PEAKS : count); }
+    void setPeakSpacing(int bins) { peak_finder.min_spacing = bins < 1 ? 1 : bins; }
+    void setInterpolation(FFT_Interp interp) { peak_finder.interp = interp; }
+
+    static constexpr int getLength() { return (int)N; }
+    float getSampleRate() { return sample_rate; }
+    const float *getMainFrequencies() { return main_Frequencies; }
+    const FFT_Peak *getPeaks() { return peaks; }
+    int getPeakCount() { return peak_count; }
+    // N/2+1 magnitudes of the last frame
+    const float *getMagnitudes() { return fft_outputbuf; }
+};
+
+template <size_t N, FFT_Window W>
+constexpr typename StaticFFT<N, W>::Tables StaticFFT<N, W>::tables;
+
+template <size_t N, FFT_Window W>
+void StaticFFT<N, W>::convert(const uint16_t *adc_buffer)
+{
+    float offset = 0.0f;
+    if (dc_removal)
+    {
+        uint32_t sum = 0;
+        for (size_t i = 0; i < N; i++)
+        {
+            sum += adc_buffer[i];
+        }
+        offset = (float)sum / N;
+    }
+
+    if (W == FFT_WINDOW_NONE)
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            fft_inputbuf[i] = (float)adc_buffer[i] - offset;
+        }
+        return;
+    }
+    for (size_t i = 0; i <= HALF; i++)
+    {
+        fft_inputbuf[i] = ((float)adc_buffer[i] - offset) * tables.window[i];
+    }
+    for (size_t i = HALF + 1; i < N; i++)
+    {
+        fft_inputbuf[i] = ((float)adc_buffer[i] - offset) * tables.window[N - i];
+    }
+}
+
+// N/2-point radix-2 CFFT over the samples packed as x[2n] + j*x[2n+1]
+template <size_t N, FFT_Window W>
+void StaticFFT<N, W>::transform()
+{
+    float *z = fft_inputbuf;
+    for (size_t s = 0; s < tables.swap_count; s++)
+    {
+        size_t i = 2 * tables.swap[s][0];
+        size_t j = 2 * tables.swap[s][1];
+        float re = z[i];
+        float im = z[i + 1];
+        z[i] = z[j];
+        z[i + 1] = z[j + 1];
+        z[j] = re;
+        z[j + 1] = im;
+    }
+
+    for (size_t size = 2; size <= HALF; size <<= 1)
+    {
+        size_t half = size >> 1;
+        // W_(N/2)^k is every second entry of the W_N table
+        size_t step = 2 * (HALF / size);
+        for (size_t start = 0; start < HALF; start += size)
+        {
+            for (size_t k = 0; k < half; k++)
+            {
+                float wr = tables.twiddle[2 * k * step];
+                float wi = tables.twiddle[2 * k * step + 1];
+                float *a = z + 2 * (start + k);
+                float *b = a + 2 * half;
+                float tr = b[0] * wr - b[1] * wi;
+                float ti = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+// Splits the packed transform into the real spectrum and keeps |X[k]|
+template <size_t N, FFT_Window W>
+void StaticFFT<N, W>::magnitude()
+{
+    const float *z = fft_inputbuf;
+    fft_outputbuf[0] = fabsf(z[0] + z[1]);
+    fft_outputbuf[HALF] = fabsf(z[0] - z[1]);
+
+    for (size_t k = 1; k < HALF; k++)
+    {
+        float ar = z[2 * k];
+        float ai = z[2 * k + 1];
+        float br = z[2 * (HALF - k)];
+        float bi = -z[2 * (HALF - k) + 1];
+        float er = 0.5f * (ar + br);
+        float ei = 0.5f * (ai + bi);
+        float orr = 0.5f * (ar - br);
+        float oi = 0.5f * (ai - bi);
+        // X[k] = E + W^k * (-j) * O
+        float wr = tables.twiddle[2 * k];
+        float wi = tables.twiddle[2 * k + 1];
+        float xr = er + wr * oi + wi * orr;
+        float xi = ei + wi * oi - wr * orr;
+        fft_outputbuf[k] = sqrtf(xr * xr + xi * xi);
+    }
+}
+
+template <size_t N, FFT_Window W>
+bool StaticFFT<N, W>::FFT_PROCESS(const uint16_t *adc_buffer)
+{
+    convert(adc_buffer);
+    transform();
+    magnitude();
+
+    peak_count = peak_finder.Find(fft_outputbuf, 1, (int)HALF - 1,
+                                  sample_rate / N, 0.0f, peaks);
+    for (int i = 0; i < FFT_MAX_PEAKS; i++)
+    {
+        main_Frequencies[i] = i < peak_count ? peaks[i].frequency : 0.0f;
+    }
+    return true;
+}
+
+#endif
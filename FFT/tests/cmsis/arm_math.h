@@ -0,0 +1,35 @@
+// Minimal stand-in for CMSIS-DSP arm_math.h: just the types and prototypes
+// FFT_Backend.cpp uses, so its CMSIS configuration builds on a host
+#ifndef _ARM_MATH_H
+#define _ARM_MATH_H
+
+#include <stdint.h>
+
+typedef float float32_t;
+typedef int16_t q15_t;
+
+typedef enum {
+    ARM_MATH_SUCCESS = 0,
+    ARM_MATH_ARGUMENT_ERROR = -1
+} arm_status;
+
+typedef struct {
+    uint16_t fftLen;
+    const float32_t *pTwiddle;
+    const uint16_t *pBitRevTable;
+    uint16_t bitRevLength;
+} arm_cfft_instance_f32;
+
+typedef struct {
+    arm_cfft_instance_f32 Sint;
+    uint16_t fftLenRFFT;
+    const float32_t *pTwiddleRFFT;
+} arm_rfft_fast_instance_f32;
+
+void arm_cfft_f32(const arm_cfft_instance_f32 *S, float32_t *p1, uint8_t ifftFlag, uint8_t bitReverseFlag);
+arm_status arm_rfft_fast_init_f32(arm_rfft_fast_instance_f32 *S, uint16_t fftLen);
+void arm_rfft_fast_f32(arm_rfft_fast_instance_f32 *S, float32_t *p, float32_t *pOut, uint8_t ifftFlag);
+void arm_cmplx_mag_f32(const float32_t *pSrc, float32_t *pDst, uint32_t numSamples);
+void arm_cmplx_mag_squared_f32(const float32_t *pSrc, float32_t *pDst, uint32_t numSamples);
+
+#endif
@@ -0,0 +1,8 @@
+// Stub of the CubeMX main.h for host builds of the CMSIS backend
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#endif
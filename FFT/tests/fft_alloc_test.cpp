@@ -0,0 +1,123 @@
+// Host test that the steady-state FFT_PROCESS/FFT_PUSH loop never touches
+// the heap, in both heap-backed and arena-backed modes. Counts every malloc
+// by wrapping the glibc allocator, so Linux hosts only.
+//   g++ -std=c++14 -O2 -I.. fft_alloc_test.cpp ../FFT.cpp ../FFT_Backend.cpp
+//       ../FFT_Tracker.cpp -o fft_alloc_test
+//   ./fft_alloc_test    (exit status 0 on success)
+
+#include "FFT.hpp"
+#include <cmath>
+#include <cstdio>
+
+extern "C" void *__libc_malloc(size_t bytes);
+extern "C" void *__libc_calloc(size_t count, size_t bytes);
+extern "C" void *__libc_realloc(void *block, size_t bytes);
+
+static volatile long allocations = 0;
+static int failures = 0;
+
+extern "C" void *malloc(size_t bytes)
+{
+    allocations++;
+    return __libc_malloc(bytes);
+}
+
+extern "C" void *calloc(size_t count, size_t bytes)
+{
+    allocations++;
+    return __libc_calloc(count, bytes);
+}
+
+extern "C" void *realloc(void *block, size_t bytes)
+{
+    allocations++;
+    return __libc_realloc(block, bytes);
+}
+
+#define CHECK(cond)                                                     \
+    do                                                                  \
+    {                                                                   \
+        if (!(cond))                                                    \
+        {                                                               \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+#define TEST_FRAMES 200
+#define TEST_SAMPLE_RATE 48000.0f
+#define TEST_TONE_HZ 3000.0f
+
+static uint16_t adc[4096];
+
+static void fill_tone(int length)
+{
+    for (int i = 0; i < length; i++)
+    {
+        adc[i] = (uint16_t)(2048.0f + 1000.0f * sinf(2.0f * (float)M_PI * TEST_TONE_HZ * i / TEST_SAMPLE_RATE));
+    }
+}
+
+// Runs the loop with every optional stage on and returns the mallocs it made
+static long run_loop(FFT *fft)
+{
+    long before = allocations;
+    for (int frame = 0; frame < TEST_FRAMES; frame++)
+    {
+        fft->FFT_PROCESS(adc);
+        fft->FFT_PUSH(adc);
+    }
+    return allocations - before;
+}
+
+static bool configure(FFT *fft)
+{
+    fft->setPeakCount(3);
+    return fft->setWindow(FFT_WINDOW_HANN) &&
+           fft->setAveraging(FFT_AVERAGE_EXPONENTIAL, 1) &&
+           fft->setOverlap(FFT_OVERLAP_50);
+}
+
+static void test_heap(int length, FFT_Mode mode)
+{
+    fill_tone(length);
+    FFT fft(length, TEST_SAMPLE_RATE, mode);
+    CHECK(configure(&fft));
+    CHECK(run_loop(&fft) == 0);
+    CHECK(fft.getPeakCount() > 0);
+    CHECK(fabsf(fft.getPeaks()[0].frequency - TEST_TONE_HZ) < TEST_SAMPLE_RATE / length);
+}
+
+// Arena sized exactly from the *_Workspace_Size helpers and deliberately
+// misaligned, the way a plain static uint8_t array may be placed
+static void test_arena(int length, FFT_Mode mode)
+{
+    static uint8_t storage[1 << 17];
+    size_t bytes = FFT::Workspace_Size(length, mode) + FFT::Window_Workspace_Size(length) +
+                   FFT::Averaging_Workspace_Size(length) + FFT::Overlap_Workspace_Size(length);
+    CHECK(bytes + 1 <= sizeof(storage));
+    uint8_t *arena = storage + 1;
+
+    fill_tone(length);
+    long before = allocations;
+    FFT fft(length, TEST_SAMPLE_RATE, arena, bytes, mode);
+    CHECK(configure(&fft));
+    CHECK(run_loop(&fft) == 0);
+    CHECK(allocations == before);
+    CHECK(fft.getPeakCount() > 0);
+    CHECK(fabsf(fft.getPeaks()[0].frequency - TEST_TONE_HZ) < TEST_SAMPLE_RATE / length);
+}
+
+int main()
+{
+    static const int lengths[] = {256, 1000, 1024};
+    for (int i = 0; i < 3; i++)
+    {
+        test_heap(lengths[i], FFT_MODE_COMPLEX);
+        test_heap(lengths[i], FFT_MODE_REAL);
+        test_arena(lengths[i], FFT_MODE_COMPLEX);
+        test_arena(lengths[i], FFT_MODE_REAL);
+    }
+    printf("%s\n", failures == 0 ? "all tests passed" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
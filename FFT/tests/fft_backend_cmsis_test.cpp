@@ -0,0 +1,147 @@
+// Host build of the CMSIS configuration of FFT_Backend.cpp against stub
+// CMSIS-DSP headers. The stubs record which instance each call receives, so
+// the test catches plans that reach arm_cfft_f32 / arm_rfft_fast_f32 without
+// having been initialised; the transforms themselves are not computed.
+//   g++ -std=c++14 -DFFT_BACKEND_CMSIS=1 -Icmsis -I.. fft_backend_cmsis_test.cpp
+//       ../FFT_Backend.cpp -o fft_backend_cmsis_test
+//   ./fft_backend_cmsis_test    (exit status 0 on success)
+
+#include "FFT_Backend.hpp"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define STUB_CFFT(n) const arm_cfft_instance_f32 arm_cfft_sR_f32_len##n = {n, NULL, NULL, 0};
+STUB_CFFT(16) STUB_CFFT(32) STUB_CFFT(64) STUB_CFFT(128) STUB_CFFT(256)
+STUB_CFFT(512) STUB_CFFT(1024) STUB_CFFT(2048) STUB_CFFT(4096)
+
+// Garbage the plans start from, as an uninitialised stack or static plan would
+#define PLAN_FILL 0xa7
+
+static const arm_cfft_instance_f32 *last_cfft = NULL;
+static const arm_rfft_fast_instance_f32 *last_rfft = NULL;
+static int failures = 0;
+
+#define CHECK(cond)                                                     \
+    do                                                                  \
+    {                                                                   \
+        if (!(cond))                                                    \
+        {                                                               \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                 \
+        }                                                               \
+    } while (0)
+
+void arm_cfft_f32(const arm_cfft_instance_f32 *S, float32_t *, uint8_t, uint8_t)
+{
+    last_cfft = S;
+}
+
+arm_status arm_rfft_fast_init_f32(arm_rfft_fast_instance_f32 *S, uint16_t fftLen)
+{
+    memset(S, 0, sizeof(*S));
+    S->fftLenRFFT = fftLen;
+    return ARM_MATH_SUCCESS;
+}
+
+void arm_rfft_fast_f32(arm_rfft_fast_instance_f32 *S, float32_t *, float32_t *, uint8_t)
+{
+    last_rfft = S;
+}
+
+void arm_cmplx_mag_f32(const float32_t *, float32_t *, uint32_t)
+{
+}
+
+void arm_cmplx_mag_squared_f32(const float32_t *, float32_t *, uint32_t)
+{
+}
+
+static const arm_cfft_instance_f32 *native_instance(int n)
+{
+    switch (n)
+    {
+    case 16:    return &arm_cfft_sR_f32_len16;
+    case 32:    return &arm_cfft_sR_f32_len32;
+    case 64:    return &arm_cfft_sR_f32_len64;
+    case 128:   return &arm_cfft_sR_f32_len128;
+    case 256:   return &arm_cfft_sR_f32_len256;
+    case 512:   return &arm_cfft_sR_f32_len512;
+    case 1024:  return &arm_cfft_sR_f32_len1024;
+    case 2048:  return &arm_cfft_sR_f32_len2048;
+    default:    return &arm_cfft_sR_f32_len4096;
+    }
+}
+
+// Native lengths need no table memory, so they are built from a NULL base
+// exactly as FFT::init_buffers() does
+static void test_native_complex(int n)
+{
+    FFT_Plan plan;
+    memset(&plan, PLAN_FILL, sizeof(plan));
+    CHECK(FFT_Plan_Size(n, false) == 0);
+    CHECK(FFT_Plan_Init(&plan, n, false, NULL));
+    CHECK(plan.kind == FFT_PLAN_RADIX2);
+    CHECK(plan.cfft == native_instance(n));
+
+    std::vector<float> data(2 * n, 0.0f);
+    last_cfft = NULL;
+    FFT_Forward_Complex(&plan, data.data());
+    CHECK(last_cfft == native_instance(n));
+    last_cfft = NULL;
+    FFT_Inverse_Complex(&plan, data.data());
+    CHECK(last_cfft == native_instance(n));
+}
+
+static void test_native_real(int n)
+{
+    FFT_Plan plan;
+    memset(&plan, PLAN_FILL, sizeof(plan));
+    CHECK(FFT_Plan_Size(n, true) == 0);
+    CHECK(FFT_Plan_Init(&plan, n, true, NULL));
+    CHECK(plan.kind == FFT_PLAN_RADIX2);
+    CHECK(plan.rfft.fftLenRFFT == n);
+
+    std::vector<float> in(n, 0.0f), out(n, 0.0f);
+    last_rfft = NULL;
+    FFT_Forward_Real(&plan, in.data(), out.data());
+    CHECK(last_rfft == &plan.rfft);
+    last_rfft = NULL;
+    FFT_Inverse_Real(&plan, out.data(), in.data());
+    CHECK(last_rfft == &plan.rfft);
+}
+
+// Split real plans nest a native complex plan inside carved memory
+static void test_split_real(int n)
+{
+    std::vector<uint8_t> memory(FFT_Plan_Size(n, true));
+    memset(memory.data(), PLAN_FILL, memory.size());
+    FFT_Plan plan;
+    memset(&plan, PLAN_FILL, sizeof(plan));
+    CHECK(!memory.empty());
+    CHECK(FFT_Plan_Init(&plan, n, true, memory.data()));
+    CHECK(plan.kind == FFT_PLAN_SPLIT);
+    CHECK(plan.inner != NULL && plan.inner->kind == FFT_PLAN_RADIX2);
+    CHECK(plan.inner != NULL && plan.inner->cfft == native_instance(n / 2));
+
+    std::vector<float> in(n, 0.0f), out(n, 0.0f);
+    last_cfft = NULL;
+    FFT_Forward_Real(&plan, in.data(), out.data());
+    CHECK(plan.inner != NULL && last_cfft == plan.inner->cfft);
+}
+
+int main()
+{
+    for (int n = 16; n <= 4096; n <<= 1)
+    {
+        test_native_complex(n);
+    }
+    for (int n = 32; n <= 4096; n <<= 1)
+    {
+        test_native_real(n);
+    }
+    // Above the CMSIS rfft range, with a native half-length plan inside
+    test_split_real(8192);
+    printf("%s\n", failures == 0 ? "all tests passed" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
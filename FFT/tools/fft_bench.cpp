@@ -0,0 +1,17 @@
+// Host entry point for the FFT benchmark harness; prints CSV to stdout.
+//   g++ -O2 -march=native -I.. fft_bench.cpp ../FFT.cpp ../FFT_Backend.cpp
+//       ../FFT_Bench.cpp ../FFT_Tracker.cpp ../SlidingDFT.cpp -o fft_bench
+//   ./fft_bench [frames] [sample_rate]
+// On target call FFTBench::Run_All with an output that writes to a Serial.
+
+#include "FFT_Bench.hpp"
+
+int main(int argc, char **argv)
+{
+    int frames = argc > 1 ? atoi(argv[1]) : 200;
+    float sample_rate = argc > 2 ? (float)atof(argv[2]) : 100000.0f;
+
+    FFTBench bench(sample_rate);
+    bench.Run_All(frames, [](const char *line) { printf("%s\n", line); });
+    return 0;
+}
@@ -0,0 +1,394 @@
+// Replays raw uint16_t ADC captures through the FFT_PROCESS stages on every
+// core and streams the peak lists out in frame order. Linux hosts only.
+//   g++ -O2 -march=native -pthread -I.. fft_replay.cpp ../FFT.cpp
+//       ../FFT_Backend.cpp ../FFT_Tracker.cpp -o fft_replay
+//   ./fft_replay [-n length] [-r sample_rate] [-m complex|real] [-k peaks]
+//                [-w none|hann|hamming|bh|flattop] [-d] [-h hop] [-j threads]
+//                [-b] [-o output] capture...
+//   ./fft_replay --help
+// CSV rows are file,frame,time,rank,frequency,magnitude. With -b every frame
+// is a fixed little-endian record instead: uint64 frame, uint32 file index,
+// uint32 peak count, then k float32 frequencies and k float32 magnitudes.
+// Each worker owns one FFT, and 2 * threads output slots are allocated up
+// front and reused round robin, so nothing is allocated per frame; a trailing
+// partial frame is ignored.
+
+#include "FFT.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define REPLAY_BATCH_FRAMES 256
+#define REPLAY_CSV_ROW 96
+
+struct Replay_Options {
+    int length = 1024;
+    float sample_rate = 100000.0f;
+    FFT_Mode mode = FFT_MODE_REAL;
+    int peaks = 5;
+    FFT_Window window = FFT_WINDOW_HANN;
+    bool dc_removal = false;
+    int hop = 0;                // 0 means one frame length
+    int threads = 0;            // 0 means one per core
+    bool binary = false;
+    const char *output = NULL;  // stdout when NULL
+};
+
+struct Replay_File {
+    const char *path;
+    const uint16_t *samples;
+    size_t mapped_bytes;
+    size_t frames;
+    size_t first_batch;
+};
+
+// Formatted output of one batch; batch is -1 while the slot is free
+struct Replay_Slot {
+    long long batch;
+    bool ready;
+    size_t bytes;
+    char *data;
+};
+
+class Replay {
+private:
+    Replay_Options opt;
+    std::vector<Replay_File> files;
+    std::vector<Replay_Slot> slots;
+    size_t batch_count;
+    size_t next_batch;
+    std::mutex lock;
+    std::condition_variable changed;
+
+    size_t slot_bytes();
+    void locate(size_t batch, int *file, size_t *first, size_t *count);
+    size_t format(int file, size_t frame, FFT *fft, char *out);
+    void worker();
+public:
+    Replay(const Replay_Options &opt);
+    ~Replay();
+    bool Map(const char *path);
+    bool Run(FILE *out);
+};
+
+Replay::Replay(const Replay_Options &opt) : opt(opt), batch_count(0), next_batch(0)
+{
+}
+
+Replay::~Replay()
+{
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        if (files[i].mapped_bytes > 0)
+        {
+            munmap((void *)files[i].samples, files[i].mapped_bytes);
+        }
+    }
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+        free(slots[i].data);
+    }
+}
+
+bool Replay::Map(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        perror(path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        perror(path);
+        close(fd);
+        return false;
+    }
+
+    Replay_File file = {path, NULL, (size_t)st.st_size, 0, batch_count};
+    size_t samples = file.mapped_bytes / sizeof(uint16_t);
+    if (samples >= (size_t)opt.length)
+    {
+        file.frames = (samples - opt.length) / opt.hop + 1;
+        void *map = mmap(NULL, file.mapped_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED)
+        {
+            perror(path);
+            close(fd);
+            return false;
+        }
+        madvise(map, file.mapped_bytes, MADV_SEQUENTIAL);
+        file.samples = (const uint16_t *)map;
+    }
+    else
+    {
+        file.mapped_bytes = 0;
+    }
+    close(fd);
+
+    batch_count += (file.frames + REPLAY_BATCH_FRAMES - 1) / REPLAY_BATCH_FRAMES;
+    files.push_back(file);
+    return true;
+}
+
+size_t Replay::slot_bytes()
+{
+    if (opt.binary)
+    {
+        return REPLAY_BATCH_FRAMES * (16 + 8 * (size_t)opt.peaks);
+    }
+    return REPLAY_BATCH_FRAMES * (size_t)opt.peaks * REPLAY_CSV_ROW;
+}
+
+// Batches never straddle files, so the last batch of a file may be short
+void Replay::locate(size_t batch, int *file, size_t *first, size_t *count)
+{
+    int f = (int)files.size() - 1;
+    while (files[f].first_batch > batch || files[f].frames == 0)
+    {
+        f--;
+    }
+    *file = f;
+    *first = (batch - files[f].first_batch) * REPLAY_BATCH_FRAMES;
+    size_t left = files[f].frames - *first;
+    *count = left < REPLAY_BATCH_FRAMES ? left : REPLAY_BATCH_FRAMES;
+}
+
+size_t Replay::format(int file, size_t frame, FFT *fft, char *out)
+{
+    const FFT_Peak *peaks = fft->getPeaks();
+    int count = fft->getPeakCount();
+
+    if (opt.binary)
+    {
+        uint64_t index = frame;
+        uint32_t header[2] = {(uint32_t)file, (uint32_t)count};
+        memcpy(out, &index, 8);
+        memcpy(out + 8, header, 8);
+        float *f = (float *)(out + 16);
+        for (int i = 0; i < opt.peaks; i++)
+        {
+            f[i] = i < count ? peaks[i].frequency : 0.0f;
+            f[opt.peaks + i] = i < count ? peaks[i].magnitude : 0.0f;
+        }
+        return 16 + 8 * (size_t)opt.peaks;
+    }
+
+    size_t bytes = 0;
+    double time = (double)frame * opt.hop / opt.sample_rate;
+    for (int i = 0; i < count; i++)
+    {
+        bytes += snprintf(out + bytes, REPLAY_CSV_ROW, "%d,%llu,%.9g,%d,%.6g,%.6g\n",
+                          file, (unsigned long long)frame, time, i,
+                          peaks[i].frequency, peaks[i].magnitude);
+    }
+    return bytes;
+}
+
+void Replay::worker()
+{
+    FFT fft(opt.length, opt.sample_rate, opt.mode);
+    fft.setPeakCount(opt.peaks);
+    fft.setWindow(opt.window);
+    fft.setDCRemoval(opt.dc_removal);
+
+    for (;;)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        if (next_batch == batch_count)
+        {
+            return;
+        }
+        size_t batch = next_batch++;
+        Replay_Slot *slot = &slots[batch % slots.size()];
+        changed.wait(guard, [slot] { return slot->batch < 0; });
+        slot->batch = (long long)batch;
+        guard.unlock();
+
+        int file;
+        size_t first, count;
+        locate(batch, &file, &first, &count);
+        size_t bytes = 0;
+        for (size_t f = first; f < first + count; f++)
+        {
+            fft.convert(files[file].samples + f * opt.hop, 1);
+            fft.transform();
+            fft.magnitude();
+            fft.search();
+            bytes += format(file, f, &fft, slot->data + bytes);
+        }
+
+        guard.lock();
+        slot->bytes = bytes;
+        slot->ready = true;
+        changed.notify_all();
+    }
+}
+
+// Workers fill slots out of order; this thread writes them back in order
+bool Replay::Run(FILE *out)
+{
+    int threads = opt.threads > 0 ? opt.threads : (int)std::thread::hardware_concurrency();
+    threads = threads > 0 ? threads : 1;
+    slots.resize(2 * threads);
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+        slots[i].batch = -1;
+        slots[i].ready = false;
+        slots[i].data = (char *)malloc(slot_bytes());
+        if (slots[i].data == NULL)
+        {
+            perror("Failed to allocate replay output");
+            return false;
+        }
+    }
+
+    if (!opt.binary)
+    {
+        fputs("file,frame,time,rank,frequency,magnitude\n", out);
+    }
+
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; i++)
+    {
+        pool.emplace_back(&Replay::worker, this);
+    }
+
+    bool ok = true;
+    for (size_t batch = 0; batch < batch_count; batch++)
+    {
+        Replay_Slot *slot = &slots[batch % slots.size()];
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [slot, batch] { return slot->batch == (long long)batch && slot->ready; });
+        guard.unlock();
+
+        if (ok && fwrite(slot->data, 1, slot->bytes, out) != slot->bytes)
+        {
+            perror("Failed to write replay output");
+            ok = false;
+        }
+
+        guard.lock();
+        slot->batch = -1;
+        slot->ready = false;
+        changed.notify_all();
+    }
+
+    for (size_t i = 0; i < pool.size(); i++)
+    {
+        pool[i].join();
+    }
+    return ok;
+}
+
+static bool parse_window(const char *name, FFT_Window *window)
+{
+    static const char *names[] = {"none", "hann", "hamming", "bh", "flattop"};
+    for (int i = 0; i < 5; i++)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            *window = (FFT_Window)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void print_usage(FILE *out, const char *argv0)
+{
+    fprintf(out,
+            "usage: %s [-n length] [-r sample_rate] [-m complex|real] [-k peaks]\n"
+            "          [-w none|hann|hamming|bh|flattop] [-d] [-h hop] [-j threads]\n"
+            "          [-b] [-o output] capture...\n"
+            "       %s --help\n", argv0, argv0);
+}
+
+static int usage(const char *argv0)
+{
+    print_usage(stderr, argv0);
+    return EXIT_FAILURE;
+}
+
+int main(int argc, char **argv)
+{
+    // -h is the hop, so help is only offered as a long option
+    for (int i = 1; i < argc && strcmp(argv[i], "--") != 0; i++)
+    {
+        if (strcmp(argv[i], "--help") == 0)
+        {
+            print_usage(stdout, argv[0]);
+            return EXIT_SUCCESS;
+        }
+    }
+
+    Replay_Options opt;
+    int opt_char;
+    while ((opt_char = getopt(argc, argv, "n:r:m:k:w:dh:j:bo:")) != -1)
+    {
+        switch (opt_char)
+        {
+        case 'n': opt.length = atoi(optarg); break;
+        case 'r': opt.sample_rate = (float)atof(optarg); break;
+        case 'm':
+            if (strcmp(optarg, "complex") == 0)     opt.mode = FFT_MODE_COMPLEX;
+            else if (strcmp(optarg, "real") == 0)   opt.mode = FFT_MODE_REAL;
+            else                                    return usage(argv[0]);
+            break;
+        case 'k': opt.peaks = atoi(optarg); break;
+        case 'w':
+            if (!parse_window(optarg, &opt.window))
+            {
+                return usage(argv[0]);
+            }
+            break;
+        case 'd': opt.dc_removal = true; break;
+        case 'h': opt.hop = atoi(optarg); break;
+        case 'j': opt.threads = atoi(optarg); break;
+        case 'b': opt.binary = true; break;
+        case 'o': opt.output = optarg; break;
+        default: return usage(argv[0]);
+        }
+    }
+    if (optind == argc || opt.peaks < 1 || opt.peaks > FFT_MAX_PEAKS || opt.hop < 0)
+    {
+        return usage(argv[0]);
+    }
+    if (!FFT::Is_Supported(opt.length, opt.mode))
+    {
+        fprintf(stderr, "Unsupported FFT length %d\n", opt.length);
+        return EXIT_FAILURE;
+    }
+    opt.hop = opt.hop > 0 ? opt.hop : opt.length;
+
+    Replay replay(opt);
+    for (int i = optind; i < argc; i++)
+    {
+        if (!replay.Map(argv[i]))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    FILE *out = opt.output != NULL ? fopen(opt.output, opt.binary ? "wb" : "w") : stdout;
+    if (out == NULL)
+    {
+        perror(opt.output);
+        return EXIT_FAILURE;
+    }
+    // Slots are already batched, so a large stdio buffer only saves syscalls
+    setvbuf(out, NULL, _IOFBF, 1 << 20);
+    bool ok = replay.Run(out);
+    if (fclose(out) != 0)
+    {
+        perror("Failed to close replay output");
+        ok = false;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
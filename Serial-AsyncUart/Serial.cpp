@@ -29,9 +29,149 @@ HAL_StatusTypeDef Serial::Init(void)
     return HAL_OK;
 }
 
-HAL_StatusTypeDef Serial::Serial_Write(uint8_t *data)
+HAL_StatusTypeDef Serial::Serial_Write(const uint8_t *data, size_t length)
 {
-    return HAL_UART_Transmit(uartHandle, data, strlen((char *)data), HAL_MAX_DELAY);
+    if (uartHandle->hdmatx == nullptr)
+    {
+        return HAL_UART_Transmit(uartHandle, const_cast<uint8_t *>(data), length, HAL_MAX_DELAY);
+    }
+    return Enqueue(data, length);
+}
+
+HAL_StatusTypeDef Serial::Enqueue(const uint8_t *data, size_t length)
+{
+    const uint32_t mask = SERIAL_TX_BUFFER_SIZE - 1;
+    uint32_t head = txHead;
+
+    if (head - txDone + length > SERIAL_TX_BUFFER_SIZE)
+    {
+        switch (txPolicy)
+        {
+        case SERIAL_TX_BLOCK:
+            // The TX-complete interrupt cannot run while we spin here
+            if (__get_IPSR() == 0 && __get_PRIMASK() == 0 && length <= SERIAL_TX_BUFFER_SIZE)
+            {
+                while (head - txDone + length > SERIAL_TX_BUFFER_SIZE)
+                {
+                    Kick_Transmit();
+                }
+                break;
+            }
+            txDropped += length;
+            return HAL_BUSY;
+        case SERIAL_TX_OVERWRITE:
+        {
+            // Free space only ever opens up at txDone, next to the DMA's
+            // chunk, so dropping the oldest unsent bytes means sliding the
+            // newer unsent bytes down over them. [txDone, txSend) is never
+            // touched; the interrupt cannot start a chunk while masked.
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            uint32_t send = txSend;
+            uint32_t used = head - txDone;
+            uint32_t excess = used + length > SERIAL_TX_BUFFER_SIZE ? used + length - SERIAL_TX_BUFFER_SIZE : 0;
+            bool fits = excess <= head - send;
+            if (fits && excess > 0)
+            {
+                for (uint32_t i = send + excess; i != head; i++)
+                {
+                    TxBuffer[(i - excess) & mask] = TxBuffer[i & mask];
+                }
+                head -= excess;
+                txHead = head;
+                txDropped += excess;
+            }
+            __set_PRIMASK(primask);
+            if (fits)
+            {
+                break;
+            }
+            txDropped += length;
+            return HAL_BUSY;
+        }
+        default:
+            txDropped += length;
+            return HAL_BUSY;
+        }
+    }
+
+    size_t first = std::min<size_t>(length, SERIAL_TX_BUFFER_SIZE - (head & mask));
+    memcpy(&TxBuffer[head & mask], data, first);
+    memcpy(TxBuffer, data + first, length - first);
+    // Publish the bytes before the index the interrupt reads
+    __DMB();
+    txHead = head + length;
+    Kick_Transmit();
+    return HAL_OK;
+}
+
+// Starts a DMA chunk if none is running; shared with the TX-complete interrupt
+void Serial::Kick_Transmit(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!txBusy)
+    {
+        Start_Transmit();
+    }
+    __set_PRIMASK(primask);
+}
+
+// Sends the longest contiguous run from txSend; interrupts must be masked
+// or this must run in the TX-complete interrupt
+void Serial::Start_Transmit(void)
+{
+    const uint32_t mask = SERIAL_TX_BUFFER_SIZE - 1;
+    uint32_t send = txSend;
+    uint32_t pending = txHead - send;
+    txDone = send;
+    if (pending == 0)
+    {
+        return;
+    }
+
+    uint32_t length = std::min<uint32_t>(pending, SERIAL_TX_BUFFER_SIZE - (send & mask));
+    uint8_t *chunk = &TxBuffer[send & mask];
+#if defined(__DCACHE_PRESENT) && (__DCACHE_PRESENT == 1U)
+    // The DMA reads memory, not the cache
+    uintptr_t start = (uintptr_t)chunk & ~(uintptr_t)31;
+    SCB_CleanDCache_by_Addr((uint32_t *)start, (int32_t)((uintptr_t)chunk + length - start));
+#endif
+    txBusy = true;
+    if (HAL_UART_Transmit_DMA(uartHandle, chunk, (uint16_t)length) != HAL_OK)
+    {
+        txBusy = false;
+        return;
+    }
+    txSend = send + length;
+}
+
+void Serial::Transmit_Complete(void)
+{
+    txBusy = false;
+    Start_Transmit();
+}
+
+void Serial::Flush(void)
+{
+    if (uartHandle->hdmatx == nullptr)
+    {
+        return;
+    }
+    while (txBusy || txSend != txHead)
+    {
+        Kick_Transmit();
+    }
+}
+
+void Serial::setTxPolicy(Serial_TxPolicy policy)
+{
+    txPolicy = policy;
+}
+
+uint32_t Serial::getTxDropped()
+{
+    return txDropped;
 }
 
 HAL_StatusTypeDef Serial::Sprintf(const char *format, ...)
@@ -49,7 +189,7 @@ HAL_StatusTypeDef Serial::Sprintf(const char *format, ...)
         return HAL_ERROR;
     }
 
-    return Serial_Write(reinterpret_cast<uint8_t *>(buffer));
+    return Serial_Write(reinterpret_cast<uint8_t *>(buffer), len);
 }
 
 UART_HandleTypeDef *Serial::getUartHandle()
@@ -81,9 +221,14 @@ std::vector<Serial *> Serial::getInstancePool()
     return Serial::InstancePool;
 }
 
+const std::vector<Serial *> &Serial::getInstances()
+{
+    return Serial::InstancePool;
+}
+
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
-    for (auto &instance : Serial::getInstancePool())
+    for (Serial *instance : Serial::getInstances())
     {
         if (huart->Instance == instance->getUartHandle()->Instance)
         {
@@ -92,3 +237,14 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
         }
     }
 }
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    for (Serial *instance : Serial::getInstances())
+    {
+        if (huart->Instance == instance->getUartHandle()->Instance)
+        {
+            instance->Transmit_Complete();
+        }
+    }
+}
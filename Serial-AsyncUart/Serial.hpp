@@ -5,12 +5,36 @@
 #include <vector>
 #include <functional>
 
+#define SERIAL_TX_BUFFER_SIZE 1024  // power of two
+
+// What Sprintf does when the DMA TX ring has no room for a line
+enum Serial_TxPolicy
+{
+    SERIAL_TX_DROP,         // discard the new line
+    SERIAL_TX_BLOCK,        // wait for the DMA to drain; drops when called from an ISR
+    SERIAL_TX_OVERWRITE     // discard the oldest bytes not yet handed to the DMA; drops the
+                            // new line if that is not enough, the DMA's chunk is never touched
+};
+
 class Serial
 {
 private:
 using RxCallback_t = std::function<void()>;
     UART_HandleTypeDef *uartHandle;
-    HAL_StatusTypeDef Serial_Write(uint8_t *data);
+    HAL_StatusTypeDef Serial_Write(const uint8_t *data, size_t length);
+    HAL_StatusTypeDef Enqueue(const uint8_t *data, size_t length);
+    void Start_Transmit(void);
+    void Kick_Transmit(void);
+    // TX ring with free-running indices: [txDone, txSend) is in flight on
+    // the DMA, [txSend, txHead) waits for the next chunk. Only Sprintf moves
+    // txHead and only the TX-complete interrupt moves txDone.
+    uint8_t TxBuffer[SERIAL_TX_BUFFER_SIZE];
+    volatile uint32_t txHead = 0;
+    volatile uint32_t txSend = 0;
+    volatile uint32_t txDone = 0;
+    volatile bool txBusy = false;
+    volatile uint32_t txDropped = 0;
+    Serial_TxPolicy txPolicy = SERIAL_TX_DROP;
     char Buffer[256]; // Buffer for receiving data, adjust size as needed
     int receiveSize = 0;
     static std::vector<Serial *> InstancePool;
@@ -18,13 +42,25 @@ public:
     Serial(UART_HandleTypeDef *uart);
     ~Serial();
     HAL_StatusTypeDef Init(void);
+    // Queues the line for DMA when the UART has a TX DMA channel linked,
+    // otherwise transmits it blocking. The ring has a single producer, so
+    // call it from one context only (main loop or one interrupt).
     HAL_StatusTypeDef Sprintf(const char *format, ...);
+    void setTxPolicy(Serial_TxPolicy policy);
+    // Bytes discarded by the overflow policy since start-up
+    uint32_t getTxDropped();
+    // Waits until every queued byte has left the DMA
+    void Flush(void);
+    // Called from HAL_UART_TxCpltCallback to chain the next chunk
+    void Transmit_Complete(void);
     RxCallback_t RxCallback = nullptr;
     UART_HandleTypeDef* getUartHandle();
     char* getBuffer();
     void Receive_IT(uint16_t size);
     int getReceiveSize();
     static std::vector<Serial*> getInstancePool();
+    // No copy, for the HAL callbacks running in interrupt context
+    static const std::vector<Serial*>& getInstances();
 };
 
 
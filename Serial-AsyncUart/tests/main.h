@@ -0,0 +1,46 @@
+// Minimal stand-in for the CubeMX main.h so Serial builds on a host. The
+// UART transmit functions are defined by the test, which plays the DMA.
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum
+{
+    HAL_OK,
+    HAL_ERROR,
+    HAL_BUSY,
+    HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+typedef struct
+{
+    uint32_t id;
+} USART_TypeDef;
+
+typedef struct
+{
+    uint32_t id;
+} DMA_HandleTypeDef;
+
+typedef struct
+{
+    USART_TypeDef *Instance;
+    DMA_HandleTypeDef *hdmatx;
+} UART_HandleTypeDef;
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size);
+
+// Single-threaded host: masking interrupts is a no-op
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t) {}
+static inline void __disable_irq(void) {}
+static inline uint32_t __get_IPSR(void) { return 0; }
+static inline void __DMB(void) {}
+
+#endif